@@ -129,6 +129,9 @@
 /* Define to 1 if you have the <bstring.h> header file. */
 /* #undef HAVE_BSTRING_H */
 
+/* Define to 1 if __builtin_ctzll is available */
+#define HAVE_BUILTIN_CTZLL 1
+
 /* Define to 1 if __builtin_expect is available */
 #define HAVE_BUILTIN_EXPECT 1
 
@@ -402,6 +405,9 @@
 /* Define to 1 if you have the `write' function. */
 #define HAVE_WRITE 1
 
+/* Define to 1 if _setjmp and _longjmp are available */
+#define HAVE__SETJMP 1
+
 /* Define to 1 if the system has the type `__int64'. */
 /* #undef HAVE___INT64 */
 
@@ -0,0 +1,928 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This file implements a benchmark driver for the library. It encodes
+** and decodes images in memory over all frame types, bit depths and
+** subsampling modes the library supports, and reports throughput,
+** compression rate, peak memory and the time spent in the individual
+** stages of the library API as a tab-separated table that can be
+** compared between runs.
+** The benchmark is not part of the libjpeg code.
+**
+*/
+
+/// Includes
+#include "std/stdio.hpp"
+#include "std/stdlib.hpp"
+#include "std/string.hpp"
+#include "std/math.hpp"
+#include "bench/bench.hpp"
+#include "cmd/iohelpers.hpp"
+#include "cmd/scans.hpp"
+#include "tools/traits.hpp"
+#include "interface/types.hpp"
+#include "interface/hooks.hpp"
+#include "interface/tagitem.hpp"
+#include "interface/parameters.hpp"
+#include "interface/jpeg.hpp"
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
+///
+
+/// Defines
+// Maximum number of synthetic image sizes and corpus files.
+#define MAX_IMAGES 64
+// Maximum loss in PSNR (dB) the rate-distortion optimizing quantizer may
+// cause compared to the regular quantizer at the same quality.
+#define MAX_RDO_LOSS 0.5
+///
+
+/// struct Workload
+// Defines one coding mode to be benchmarked.
+struct Workload {
+  // Name of the workload as it appears in the report.
+  const char *wl_pName;
+  // Frame type of the legacy (base) codestream.
+  int         wl_iFrameType;
+  // Frame type of the residual codestream, if residual coding is enabled.
+  int         wl_iResidualType;
+  // Sample precision the workload runs at.
+  UBYTE       wl_ucPrecision;
+  // Subsampling factors of the chroma components.
+  UBYTE       wl_ucSubX;
+  UBYTE       wl_ucSubY;
+  // Quality of the base and the residual codestream, -1 if not used.
+  int         wl_iQuality;
+  int         wl_iHDRQuality;
+  // Number of resolution levels for the pyramidal mode.
+  int         wl_iLevels;
+  // The color transformation to use.
+  int         wl_iColorTrafo;
+  // Strength of the rate-distortion optimizing quantizer, zero if disabled.
+  int         wl_iOptimize;
+};
+///
+
+/// Workloads
+// The list of coding modes to run. Each image runs all workloads
+// of its precision.
+static const struct Workload Workloads[] = {
+  {"baseline-444"     ,JPGFLAG_BASELINE                            ,0,
+   8,1,1,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"baseline-422"     ,JPGFLAG_BASELINE                            ,0,
+   8,2,1,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"baseline-420"     ,JPGFLAG_BASELINE                            ,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"optimized-420"    ,JPGFLAG_SEQUENTIAL | JPGFLAG_OPTIMIZE_HUFFMAN,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"extended-12-420"  ,JPGFLAG_SEQUENTIAL | JPGFLAG_OPTIMIZE_HUFFMAN,0,
+   12,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"trellis-420"      ,JPGFLAG_SEQUENTIAL | JPGFLAG_OPTIMIZE_HUFFMAN,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,8},
+  {"trellis-12-420"   ,JPGFLAG_SEQUENTIAL | JPGFLAG_OPTIMIZE_HUFFMAN,0,
+   12,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,8},
+  {"progressive-420"  ,JPGFLAG_PROGRESSIVE                         ,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"arithmetic-420"   ,JPGFLAG_SEQUENTIAL | JPGFLAG_ARITHMETIC     ,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"progressive-ac-420",JPGFLAG_PROGRESSIVE | JPGFLAG_ARITHMETIC   ,0,
+   8,2,2,85,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"pyramidal-420"    ,JPGFLAG_SEQUENTIAL | JPGFLAG_PYRAMIDAL | JPGFLAG_OPTIMIZE_HUFFMAN,0,
+   8,2,2,85,-1,3,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"lossless-8"       ,JPGFLAG_LOSSLESS                            ,0,
+   8,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"lossless-12"      ,JPGFLAG_LOSSLESS                            ,0,
+   12,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"lossless-16"      ,JPGFLAG_LOSSLESS                            ,0,
+   16,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"lossless-ac-16"   ,JPGFLAG_LOSSLESS | JPGFLAG_ARITHMETIC       ,0,
+   16,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"jpegls-8"         ,JPGFLAG_JPEG_LS                             ,0,
+   8,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"jpegls-12"        ,JPGFLAG_JPEG_LS                             ,0,
+   12,1,1,-1,-1,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE,0},
+  {"residual-8"       ,JPGFLAG_SEQUENTIAL | JPGFLAG_RESIDUAL_CODING | JPGFLAG_OPTIMIZE_HUFFMAN,
+   JPGFLAG_RESIDUAL,
+   8,1,1,85,100,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"residualdct-8"    ,JPGFLAG_SEQUENTIAL | JPGFLAG_RESIDUAL_CODING | JPGFLAG_OPTIMIZE_HUFFMAN,
+   JPGFLAG_RESIDUALDCT,
+   8,1,1,85,100,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"residual-12-420"  ,JPGFLAG_SEQUENTIAL | JPGFLAG_RESIDUAL_CODING | JPGFLAG_OPTIMIZE_HUFFMAN,
+   JPGFLAG_SEQUENTIAL,
+   12,2,2,85,85,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {"residual-16"      ,JPGFLAG_SEQUENTIAL | JPGFLAG_RESIDUAL_CODING | JPGFLAG_OPTIMIZE_HUFFMAN,
+   JPGFLAG_RESIDUAL,
+   16,1,1,85,100,0,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR,0},
+  {NULL,0,0,0,0,0,0,0,0,0,0}
+};
+///
+
+/// struct BenchImage
+// An image held in memory, samples interleaved, one byte per sample
+// for up to eight bits, two bytes per sample (native endianness) otherwise.
+struct BenchImage {
+  // The name of the image as it appears in the report.
+  const char *bi_pName;
+  // The sample memory.
+  UBYTE      *bi_pMem;
+  // Dimensions.
+  ULONG       bi_ulWidth;
+  ULONG       bi_ulHeight;
+  // Number of components and the sample precision.
+  UBYTE       bi_ucDepth;
+  UBYTE       bi_ucPrecision;
+};
+///
+
+/// struct MemoryStream
+// A growable memory buffer the codestream is written to and read from.
+struct MemoryStream {
+  UBYTE *ms_pBuffer;
+  ULONG  ms_ulSize;
+  ULONG  ms_ulAllocated;
+  ULONG  ms_ulPos;
+};
+///
+
+/// struct MemoryStatistics
+// Collects the memory requested by the library through the allocation hooks.
+struct MemoryStatistics {
+  UQUAD  ms_uqCurrent;
+  UQUAD  ms_uqPeak;
+};
+///
+
+/// struct StageTimes
+// Seconds spent in each of the library API calls.
+struct StageTimes {
+  double st_dProvide; // JPEG::ProvideImage, encoding
+  double st_dWrite;   // JPEG::Write, encoding
+  double st_dRead;    // JPEG::Read, decoding
+  double st_dDisplay; // JPEG::DisplayRectangle, decoding
+};
+///
+
+/// Now
+// Return a wall clock time in seconds.
+static double Now(void)
+{
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  
+  gettimeofday(&tv,NULL);
+  
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+#else
+  return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+///
+
+/// MemoryHook
+// The IO hook function reading from and writing to a memory stream.
+static JPG_LONG MemoryHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
+{
+  struct MemoryStream *ms = (struct MemoryStream *)(hook->hk_pData);
+
+  switch(tags->GetTagData(JPGTAG_FIO_ACTION)) {
+  case JPGFLAG_ACTION_READ:
+    {
+      UBYTE *buffer = (UBYTE *)tags->GetTagPtr(JPGTAG_FIO_BUFFER);
+      ULONG  size   = (ULONG  )tags->GetTagData(JPGTAG_FIO_SIZE);
+
+      if (size > ms->ms_ulSize - ms->ms_ulPos)
+        size = ms->ms_ulSize - ms->ms_ulPos;
+      memcpy(buffer,ms->ms_pBuffer + ms->ms_ulPos,size);
+      ms->ms_ulPos += size;
+      
+      return size;
+    }
+  case JPGFLAG_ACTION_WRITE:
+    {
+      UBYTE *buffer = (UBYTE *)tags->GetTagPtr(JPGTAG_FIO_BUFFER);
+      ULONG  size   = (ULONG  )tags->GetTagData(JPGTAG_FIO_SIZE);
+
+      if (ms->ms_ulPos + size > ms->ms_ulAllocated) {
+        ULONG  alloc = ms->ms_ulAllocated * 2 + size + 4096;
+        UBYTE *mem   = (UBYTE *)realloc(ms->ms_pBuffer,alloc);
+        if (mem == NULL)
+          return -1;
+        ms->ms_pBuffer     = mem;
+        ms->ms_ulAllocated = alloc;
+      }
+      memcpy(ms->ms_pBuffer + ms->ms_ulPos,buffer,size);
+      ms->ms_ulPos += size;
+      if (ms->ms_ulPos > ms->ms_ulSize)
+        ms->ms_ulSize = ms->ms_ulPos;
+      
+      return size;
+    }
+  case JPGFLAG_ACTION_SEEK:
+    {
+      LONG mode   = tags->GetTagData(JPGTAG_FIO_SEEKMODE);
+      LONG offset = tags->GetTagData(JPGTAG_FIO_OFFSET);
+      LONG pos;
+
+      switch(mode) {
+      case JPGFLAG_OFFSET_CURRENT:
+        pos = ms->ms_ulPos + offset;
+        break;
+      case JPGFLAG_OFFSET_BEGINNING:
+        pos = offset;
+        break;
+      case JPGFLAG_OFFSET_END:
+        pos = ms->ms_ulSize + offset;
+        break;
+      default:
+        return -1;
+      }
+      if (pos < 0 || ULONG(pos) > ms->ms_ulSize)
+        return -1;
+      ms->ms_ulPos = pos;
+      return 0;
+    }
+  case JPGFLAG_ACTION_QUERY:
+    return 0;
+  case JPGFLAG_ACTION_PREFETCH:
+    // Everything is in memory already.
+    return 0;
+  }
+  return -1;
+}
+///
+
+/// AllocationHook
+// Allocate memory for the library and keep book on the memory in use.
+static JPG_APTR AllocationHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
+{
+  struct MemoryStatistics *stats = (struct MemoryStatistics *)(hook->hk_pData);
+  ULONG size = tags->GetTagData(JPGTAG_MIO_SIZE);
+  void *mem  = malloc(size);
+
+  if (mem) {
+    stats->ms_uqCurrent += size;
+    if (stats->ms_uqCurrent > stats->ms_uqPeak)
+      stats->ms_uqPeak = stats->ms_uqCurrent;
+  }
+  
+  return mem;
+}
+///
+
+/// ReleaseHook
+// Release memory of the library again. The library always passes the
+// size of the block in.
+static JPG_LONG ReleaseHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
+{
+  struct MemoryStatistics *stats = (struct MemoryStatistics *)(hook->hk_pData);
+  ULONG size = tags->GetTagData(JPGTAG_MIO_SIZE);
+  void *mem  = tags->GetTagPtr(JPGTAG_MIO_MEMORY);
+
+  if (mem) {
+    stats->ms_uqCurrent -= size;
+    free(mem);
+  }
+
+  return 0;
+}
+///
+
+/// BenchBitmapHook
+// The bitmap hook delivering or accepting image data. As the full image
+// is kept in memory, this just points the library to the right sample.
+// Like the bitmap hook of the command line tool, it indicates eight lines
+// to be available per request, the library clips them to the image.
+static JPG_LONG BenchBitmapHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
+{
+  struct BenchImage *img = (struct BenchImage *)(hook->hk_pData);
+  UWORD comp  = tags->GetTagData(JPGTAG_BIO_COMPONENT);
+  ULONG miny  = tags->GetTagData(JPGTAG_BIO_MINY);
+  UBYTE bytes = (img->bi_ucPrecision > 8)?(sizeof(UWORD)):(sizeof(UBYTE));
+
+  if (tags->GetTagData(JPGTAG_BIO_ACTION) == JPGFLAG_BIO_REQUEST) {
+    ULONG height = miny + 8;
+    tags->SetTagPtr(JPGTAG_BIO_MEMORY        ,img->bi_pMem + comp * bytes);
+    tags->SetTagData(JPGTAG_BIO_WIDTH        ,img->bi_ulWidth);
+    tags->SetTagData(JPGTAG_BIO_HEIGHT       ,height);
+    tags->SetTagData(JPGTAG_BIO_BYTESPERROW  ,img->bi_ulWidth * img->bi_ucDepth * bytes);
+    tags->SetTagData(JPGTAG_BIO_BYTESPERPIXEL,img->bi_ucDepth * bytes);
+    tags->SetTagData(JPGTAG_BIO_PIXELTYPE    ,(bytes > 1)?(CTYP_UWORD):(CTYP_UBYTE));
+  }
+  
+  return 0;
+}
+///
+
+/// AllocImage
+// Allocate the sample memory of an image.
+static bool AllocImage(struct BenchImage *img,const char *name,ULONG width,ULONG height,
+                       UBYTE depth,UBYTE prec)
+{
+  size_t bytes = (prec > 8)?(sizeof(UWORD)):(sizeof(UBYTE));
+
+  img->bi_pName       = name;
+  img->bi_ulWidth     = width;
+  img->bi_ulHeight    = height;
+  img->bi_ucDepth     = depth;
+  img->bi_ucPrecision = prec;
+  img->bi_pMem        = (UBYTE *)malloc(size_t(width) * height * depth * bytes);
+
+  return img->bi_pMem != NULL;
+}
+///
+
+/// GenerateImage
+// Create a synthetic test image of the given precision. The image contains
+// smooth gradients, sharp edges and some noise such that all parts of
+// the coding pipeline are exercised. The content is deterministic.
+static void GenerateImage(struct BenchImage *img)
+{
+  ULONG seed = 0x2545f491UL;
+  ULONG max  = (1UL << img->bi_ucPrecision) - 1;
+  ULONG x,y;
+  UBYTE c;
+  UBYTE *bp  = img->bi_pMem;
+  UWORD *wp  = (UWORD *)img->bi_pMem;
+
+  for(y = 0;y < img->bi_ulHeight;y++) {
+    for(x = 0;x < img->bi_ulWidth;x++) {
+      for(c = 0;c < img->bi_ucDepth;c++) {
+        ULONG v;
+        // A linear congruential generator for the noise.
+        seed = seed * 1664525UL + 1013904223UL;
+        v    = (x * (c + 1) + y * (3 - c)) & 511;     // gradients
+        v   += ((x / 37 + y / 23) & 1) << 8;          // edges
+        v   += (seed >> 24) & 31;                     // noise
+        v    = (v * max) / (511 + 256 + 31);
+        if (img->bi_ucPrecision > 8) {
+          *wp++ = UWORD(v);
+        } else {
+          *bp++ = UBYTE(v);
+        }
+      }
+    }
+  }
+}
+///
+
+/// LoadImage
+// Load an image from a PGM or PPM file. Returns false if the file cannot be
+// used for benchmarking.
+static bool LoadImage(struct BenchImage *img,const char *name)
+{
+  int width,height,depth,prec;
+  bool flt,big;
+  FILE *in = OpenPNMFile(name,width,height,depth,prec,flt,big);
+  bool ok  = false;
+
+  if (in) {
+    if (flt) {
+      fprintf(stderr,"%s: floating point images are not supported by the benchmark\n",name);
+    } else {
+      if (prec < 8)
+        prec = 8;
+      if (AllocImage(img,name,width,height,depth,prec)) {
+        size_t count = size_t(width) * height * depth;
+        if (prec > 8) {
+          if (fread(img->bi_pMem,sizeof(UWORD),count,in) == count) {
+            UWORD *data = (UWORD *)img->bi_pMem;
+#ifdef JPG_LIL_ENDIAN
+            // PNM is big-endian.
+            while(count--) {
+              *data = (*data >> 8) | ((*data & 0xff) << 8);
+              data++;
+            }
+#endif
+            ok = true;
+          }
+        } else {
+          ok = fread(img->bi_pMem,sizeof(UBYTE),count,in) == count;
+        }
+        if (!ok) {
+          fprintf(stderr,"%s: unexpected end of file\n",name);
+          free(img->bi_pMem);
+        }
+      } else {
+        fprintf(stderr,"%s: out of memory\n",name);
+      }
+    }
+    fclose(in);
+  }
+
+  return ok;
+}
+///
+
+/// MaxError
+// Return the maximum absolute difference between two images of the same layout.
+static ULONG MaxError(const struct BenchImage *a,const struct BenchImage *b)
+{
+  size_t count = size_t(a->bi_ulWidth) * a->bi_ulHeight * a->bi_ucDepth;
+  ULONG err    = 0;
+
+  if (a->bi_ucPrecision > 8) {
+    const UWORD *p = (const UWORD *)a->bi_pMem;
+    const UWORD *q = (const UWORD *)b->bi_pMem;
+    while(count--) {
+      ULONG d = (*p > *q)?(*p - *q):(*q - *p);
+      if (d > err)
+        err = d;
+      p++,q++;
+    }
+  } else {
+    const UBYTE *p = a->bi_pMem;
+    const UBYTE *q = b->bi_pMem;
+    while(count--) {
+      ULONG d = (*p > *q)?(*p - *q):(*q - *p);
+      if (d > err)
+        err = d;
+      p++,q++;
+    }
+  }
+
+  return err;
+}
+///
+
+/// PSNR
+// Return the peak signal to noise ratio in dB between two images of the same layout.
+static double PSNR(const struct BenchImage *a,const struct BenchImage *b)
+{
+  size_t count = size_t(a->bi_ulWidth) * a->bi_ulHeight * a->bi_ucDepth;
+  double peak  = double((1UL << a->bi_ucPrecision) - 1);
+  double sum   = 0.0;
+  size_t i;
+
+  if (a->bi_ucPrecision > 8) {
+    const UWORD *p = (const UWORD *)a->bi_pMem;
+    const UWORD *q = (const UWORD *)b->bi_pMem;
+    for(i = 0;i < count;i++) {
+      double d = double(p[i]) - double(q[i]);
+      sum += d * d;
+    }
+  } else {
+    const UBYTE *p = a->bi_pMem;
+    const UBYTE *q = b->bi_pMem;
+    for(i = 0;i < count;i++) {
+      double d = double(p[i]) - double(q[i]);
+      sum += d * d;
+    }
+  }
+
+  if (sum <= 0.0)
+    return HUGE_VAL;
+  
+  return 10.0 * log10(peak * peak * count / sum);
+}
+///
+
+/// Encode
+// Encode the image with the given workload into the memory stream.
+// Returns zero on success, otherwise the error code of the library.
+static int Encode(const struct Workload *wl,struct BenchImage *img,struct MemoryStream *ms,
+                  struct StageTimes *times,struct MemoryStatistics *stats,const char *&error)
+{
+  struct JPG_Hook allochook(AllocationHook,stats);
+  struct JPG_Hook releasehook(ReleaseHook,stats);
+  struct JPG_Hook bmhook(BenchBitmapHook,img);
+  struct JPG_Hook iohook(MemoryHook,ms);
+  struct JPG_TagItem ctags[] = {
+    JPG_PointerTag(JPGTAG_MIO_ALLOC_HOOK,&allochook),
+    JPG_PointerTag(JPGTAG_MIO_RELEASE_HOOK,&releasehook),
+    JPG_EndTag
+  };
+  UBYTE subx[4],suby[4];
+  UWORD tonemapping[256];
+  bool  residual    = (wl->wl_iFrameType & JPGFLAG_RESIDUAL_CODING) && img->bi_ucPrecision > 8;
+  bool  progressive = (wl->wl_iFrameType & 0x07) == JPGFLAG_PROGRESSIVE;
+  int   i,code   = 0;
+  double t;
+  //
+  // The chroma components are subsampled, the luma component is not.
+  for(i = 0;i < 4;i++) {
+    subx[i] = (i > 0)?(wl->wl_ucSubX):(1);
+    suby[i] = (i > 0)?(wl->wl_ucSubY):(1);
+  }
+  //
+  // High bit depth residual coding requires a tone mapping from the eight bit
+  // legacy image to the full range. A linear one will do.
+  for(i = 0;i < 256;i++) {
+    tonemapping[i] = (i * ((1UL << img->bi_ucPrecision) - 1) + 127) / 255;
+  }
+  //
+  struct JPG_TagItem tags[] = {
+    JPG_PointerTag(JPGTAG_BIH_HOOK,&bmhook),
+    JPG_ValueTag(JPGTAG_ENCODER_LOOP_ON_INCOMPLETE,true),
+    JPG_ValueTag(JPGTAG_IMAGE_WIDTH,img->bi_ulWidth),
+    JPG_ValueTag(JPGTAG_IMAGE_HEIGHT,img->bi_ulHeight),
+    JPG_ValueTag(JPGTAG_IMAGE_DEPTH,img->bi_ucDepth),
+    JPG_ValueTag(JPGTAG_IMAGE_PRECISION,img->bi_ucPrecision),
+    JPG_ValueTag(JPGTAG_IMAGE_FRAMETYPE,wl->wl_iFrameType),
+    JPG_ValueTag((wl->wl_iFrameType & JPGFLAG_RESIDUAL_CODING)?
+                 JPGTAG_RESIDUAL_FRAMETYPE:JPGTAG_TAG_IGNORE,wl->wl_iResidualType),
+    JPG_ValueTag((wl->wl_iQuality >= 0)?JPGTAG_IMAGE_QUALITY:JPGTAG_TAG_IGNORE,wl->wl_iQuality),
+    JPG_ValueTag((wl->wl_iHDRQuality >= 0)?JPGTAG_RESIDUAL_QUALITY:JPGTAG_TAG_IGNORE,
+                 wl->wl_iHDRQuality),
+    JPG_ValueTag((wl->wl_iResidualType == JPGFLAG_RESIDUALDCT)?
+                 JPGTAG_RESIDUAL_DCT:JPGTAG_TAG_IGNORE,true),
+    JPG_ValueTag(JPGTAG_IMAGE_RESOLUTIONLEVELS,wl->wl_iLevels),
+    JPG_ValueTag(JPGTAG_MATRIX_LTRAFO,wl->wl_iColorTrafo),
+    JPG_ValueTag(JPGTAG_OPTIMIZE_QUANTIZER,wl->wl_iOptimize),
+    JPG_PointerTag(JPGTAG_IMAGE_SUBX,subx),
+    JPG_PointerTag(JPGTAG_IMAGE_SUBY,suby),
+    JPG_PointerTag((residual)?(JPGTAG_TONEMAPPING_L_LUT(0)):JPGTAG_TAG_IGNORE,tonemapping),
+    JPG_PointerTag((residual && img->bi_ucDepth > 1)?(JPGTAG_TONEMAPPING_L_LUT(1)):JPGTAG_TAG_IGNORE,
+                   tonemapping),
+    JPG_PointerTag((residual && img->bi_ucDepth > 2)?(JPGTAG_TONEMAPPING_L_LUT(2)):JPGTAG_TAG_IGNORE,
+                   tonemapping),
+    JPG_ValueTag((residual)?(JPGTAG_TONEMAPPING_L_TYPE(0)):JPGTAG_TAG_IGNORE,
+                 JPGFLAG_TONEMAPPING_LUT),
+    JPG_ValueTag((residual && img->bi_ucDepth > 1)?(JPGTAG_TONEMAPPING_L_TYPE(1)):JPGTAG_TAG_IGNORE,
+                 JPGFLAG_TONEMAPPING_LUT),
+    JPG_ValueTag((residual && img->bi_ucDepth > 2)?(JPGTAG_TONEMAPPING_L_TYPE(2)):JPGTAG_TAG_IGNORE,
+                 JPGFLAG_TONEMAPPING_LUT),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan1),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan2),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan3),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan4),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan5),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan6),
+    JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan7),
+    JPG_EndTag
+  };
+  struct JPG_TagItem iotags[] = {
+    JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&iohook),
+    JPG_EndTag
+  };
+  class JPEG *jpeg = JPEG::Construct(ctags);
+  
+  if (jpeg == NULL) {
+    error = "failed to construct the JPEG object";
+    return -1;
+  }
+  //
+  t = Now();
+  if (jpeg->ProvideImage(tags)) {
+    times->st_dProvide = Now() - t;
+    t = Now();
+    if (jpeg->Write(iotags)) {
+      times->st_dWrite = Now() - t;
+    } else {
+      code = jpeg->LastError(error);
+    }
+  } else {
+    code = jpeg->LastError(error);
+  }
+  //
+  JPEG::Destruct(jpeg);
+
+  return code;
+}
+///
+
+/// Decode
+// Decode the image from the memory stream into the given image.
+// Returns zero on success, otherwise the error code of the library.
+static int Decode(struct BenchImage *img,struct MemoryStream *ms,
+                  struct StageTimes *times,struct MemoryStatistics *stats,const char *&error)
+{
+  struct JPG_Hook allochook(AllocationHook,stats);
+  struct JPG_Hook releasehook(ReleaseHook,stats);
+  struct JPG_Hook bmhook(BenchBitmapHook,img);
+  struct JPG_Hook iohook(MemoryHook,ms);
+  struct JPG_TagItem ctags[] = {
+    JPG_PointerTag(JPGTAG_MIO_ALLOC_HOOK,&allochook),
+    JPG_PointerTag(JPGTAG_MIO_RELEASE_HOOK,&releasehook),
+    JPG_EndTag
+  };
+  struct JPG_TagItem iotags[] = {
+    JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&iohook),
+    JPG_EndTag
+  };
+  struct JPG_TagItem tags[] = {
+    JPG_PointerTag(JPGTAG_BIH_HOOK,&bmhook),
+    JPG_ValueTag(JPGTAG_DECODER_MINY,0),
+    JPG_ValueTag(JPGTAG_DECODER_MAXY,img->bi_ulHeight - 1),
+    JPG_EndTag
+  };
+  class JPEG *jpeg = JPEG::Construct(ctags);
+  int code = 0;
+  double t;
+  
+  if (jpeg == NULL) {
+    error = "failed to construct the JPEG object";
+    return -1;
+  }
+  //
+  ms->ms_ulPos = 0;
+  t = Now();
+  if (jpeg->Read(iotags)) {
+    ULONG y = 0;
+    times->st_dRead = Now() - t;
+    t = Now();
+    //
+    // Reconstruct the image in stripes of eight lines as the bitmap
+    // hook only takes eight lines at a time.
+    do {
+      ULONG lastline = img->bi_ulHeight;
+      if (lastline > y + 8)
+        lastline = y + 8;
+      tags[1].ti_Data.ti_lData = y;
+      tags[2].ti_Data.ti_lData = lastline - 1;
+      if (!jpeg->DisplayRectangle(tags)) {
+        code = jpeg->LastError(error);
+        break;
+      }
+      y = lastline;
+    } while(y < img->bi_ulHeight);
+    times->st_dDisplay = Now() - t;
+  } else {
+    code = jpeg->LastError(error);
+  }
+  //
+  JPEG::Destruct(jpeg);
+
+  return code;
+}
+///
+
+/// CheckOptimization
+// Check that the rate-distortion optimizing quantizer of the workload
+// does not lower the quality noticeably. For that, encode the image
+// once more with the regular quantizer and compare the PSNR against
+// that of the optimized reconstruction out. Returns zero on success.
+static int CheckOptimization(const struct Workload *wl,struct BenchImage *img,
+                             const struct BenchImage *out,const char *&error)
+{
+  struct Workload plain   = *wl;
+  struct BenchImage ref   = *img;
+  struct MemoryStream ms;
+  struct MemoryStatistics stats;
+  struct StageTimes times;
+  int code                = 0;
+  //
+  memset(&ms,0,sizeof(ms));
+  memset(&stats,0,sizeof(stats));
+  memset(&times,0,sizeof(times));
+  plain.wl_iOptimize = 0;
+  //
+  if (!AllocImage(&ref,img->bi_pName,img->bi_ulWidth,img->bi_ulHeight,
+                  img->bi_ucDepth,img->bi_ucPrecision)) {
+    error = "out of memory";
+    return -1;
+  }
+  //
+  code = Encode(&plain,img,&ms,&times,&stats,error);
+  if (code == 0)
+    code = Decode(&ref,&ms,&times,&stats,error);
+  if (code == 0 && PSNR(img,out) < PSNR(img,&ref) - MAX_RDO_LOSS) {
+    error = "the rate-distortion optimization lowered the PSNR too much";
+    code  = -1;
+  }
+  //
+  free(ref.bi_pMem);
+  free(ms.ms_pBuffer);
+
+  return code;
+}
+///
+
+/// RunWorkload
+// Run a single workload on an image repeatedly and report the results
+// in one line of the table. Returns false if the workload failed.
+static bool RunWorkload(const struct Workload *wl,struct BenchImage *img,int repetitions)
+{
+  struct BenchImage out = *img;
+  struct MemoryStream ms;
+  struct MemoryStatistics encstats,decstats;
+  struct StageTimes best;
+  const char *error = NULL;
+  double pixels     = double(img->bi_ulWidth) * img->bi_ulHeight;
+  ULONG  maxerr     = 0;
+  int code          = 0;
+  int i;
+  //
+  memset(&ms,0,sizeof(ms));
+  memset(&encstats,0,sizeof(encstats));
+  memset(&decstats,0,sizeof(decstats));
+  memset(&best,0,sizeof(best));
+  //
+  if (!AllocImage(&out,img->bi_pName,img->bi_ulWidth,img->bi_ulHeight,
+                  img->bi_ucDepth,img->bi_ucPrecision)) {
+    error = "out of memory";
+    code  = -1;
+  }
+  //
+  for(i = 0;i < repetitions && code == 0;i++) {
+    struct StageTimes times;
+    memset(&times,0,sizeof(times));
+    ms.ms_ulSize = 0;
+    ms.ms_ulPos  = 0;
+    code = Encode(wl,img,&ms,&times,&encstats,error);
+    if (code == 0)
+      code = Decode(&out,&ms,&times,&decstats,error);
+    if (code == 0) {
+      if (i == 0 || times.st_dProvide < best.st_dProvide) best.st_dProvide = times.st_dProvide;
+      if (i == 0 || times.st_dWrite   < best.st_dWrite)   best.st_dWrite   = times.st_dWrite;
+      if (i == 0 || times.st_dRead    < best.st_dRead)    best.st_dRead    = times.st_dRead;
+      if (i == 0 || times.st_dDisplay < best.st_dDisplay) best.st_dDisplay = times.st_dDisplay;
+    }
+  }
+  //
+  if (code == 0 && wl->wl_iOptimize)
+    code = CheckOptimization(wl,img,&out,error);
+  //
+  if (code == 0)
+    maxerr = MaxError(img,&out);
+  //
+  printf("%s\t%s\t%lu\t%lu\t%d\t%d\t%d%d\t",
+         img->bi_pName,wl->wl_pName,
+         (unsigned long)img->bi_ulWidth,(unsigned long)img->bi_ulHeight,
+         img->bi_ucDepth,img->bi_ucPrecision,
+         (img->bi_ucDepth > 1)?(wl->wl_ucSubX):(1),(img->bi_ucDepth > 1)?(wl->wl_ucSubY):(1));
+  if (code == 0) {
+    double enc = best.st_dProvide + best.st_dWrite;
+    double dec = best.st_dRead    + best.st_dDisplay;
+    printf("%lu\t%.4f\t%.2f\t%.2f\t%.3f\t%.3f\t%.3f\t%.3f\t%llu\t%llu\t%lu\tok\n",
+           (unsigned long)ms.ms_ulSize,ms.ms_ulSize / pixels,
+           (enc > 0.0)?(pixels * 1e-6 / enc):(0.0),
+           (dec > 0.0)?(pixels * 1e-6 / dec):(0.0),
+           best.st_dProvide * 1000.0,best.st_dWrite   * 1000.0,
+           best.st_dRead    * 1000.0,best.st_dDisplay * 1000.0,
+           (unsigned long long)encstats.ms_uqPeak,(unsigned long long)decstats.ms_uqPeak,
+           (unsigned long)maxerr);
+  } else {
+    printf("-\t-\t-\t-\t-\t-\t-\t-\t-\t-\t-\terror %d: %s\n",code,(error)?(error):"unknown");
+  }
+  fflush(stdout);
+  //
+  free(out.bi_pMem);
+  free(ms.ms_pBuffer);
+
+  return code == 0;
+}
+///
+
+/// Usage
+// Print the command line options.
+static void Usage(const char *progname)
+{
+  fprintf(stderr,
+          "Usage: %s [options] [image.pgm|image.ppm ...]\n\n"
+          "Encodes and decodes images in memory over all supported coding modes\n"
+          "and writes a tab-separated report to stdout. Without image files,\n"
+          "synthetic images are used.\n\n"
+          "-s WxH     : size of a synthetic image, can be given multiple times\n"
+          "             defaults to 512x512 and 2048x1536\n"
+          "-d depth   : number of components of the synthetic images, 1 or 3 (default)\n"
+          "-n reps    : number of repetitions, the fastest run is reported (default 3)\n"
+          "-w name    : run only workloads whose name contains the given string\n\n"
+          "Columns: image, workload, width, height, depth, precision, chroma subsampling,\n"
+          "codestream bytes, bytes per pixel, encoding and decoding Mpixels/s,\n"
+          "milliseconds spent in ProvideImage, Write, Read and DisplayRectangle,\n"
+          "peak library memory in bytes for encoding and decoding, maximum sample\n"
+          "error and status. The exit code is nonzero if any workload failed.\n",
+          progname);
+}
+///
+
+/// main
+int main(int argc,char **argv)
+{
+  const char *progname = argv[0];
+  const char *filter   = NULL;
+  ULONG widths[MAX_IMAGES],heights[MAX_IMAGES];
+  const char *files[MAX_IMAGES];
+  int sizes = 0,nfiles = 0;
+  int depth = 3;
+  int repetitions = 3;
+  int failures = 0;
+  int i;
+  //
+  for(i = 1;i < argc;i++) {
+    if (!strcmp(argv[i],"-s") && i + 1 < argc) {
+      unsigned long w,h;
+      if (sizes >= MAX_IMAGES || sscanf(argv[++i],"%lux%lu",&w,&h) != 2 || w == 0 || h == 0) {
+        Usage(progname);
+        return 20;
+      }
+      widths[sizes]  = w;
+      heights[sizes] = h;
+      sizes++;
+    } else if (!strcmp(argv[i],"-d") && i + 1 < argc) {
+      depth = atoi(argv[++i]);
+      if (depth != 1 && depth != 3) {
+        Usage(progname);
+        return 20;
+      }
+    } else if (!strcmp(argv[i],"-n") && i + 1 < argc) {
+      repetitions = atoi(argv[++i]);
+      if (repetitions < 1)
+        repetitions = 1;
+    } else if (!strcmp(argv[i],"-w") && i + 1 < argc) {
+      filter = argv[++i];
+    } else if (argv[i][0] == '-') {
+      Usage(progname);
+      return 20;
+    } else if (nfiles < MAX_IMAGES) {
+      files[nfiles++] = argv[i];
+    }
+  }
+  //
+  if (sizes == 0 && nfiles == 0) {
+    widths[0] = 512;  heights[0] = 512;
+    widths[1] = 2048; heights[1] = 1536;
+    sizes     = 2;
+  }
+  //
+  printf("#image\tworkload\twidth\theight\tdepth\tprecision\tsubsampling\t"
+         "bytes\tbytes/pixel\tenc_mpix/s\tdec_mpix/s\t"
+         "provide_ms\twrite_ms\tread_ms\tdisplay_ms\t"
+         "enc_peak_bytes\tdec_peak_bytes\tmax_error\tstatus\n");
+  //
+  // Run the synthetic images for all precisions the workloads need.
+  for(i = 0;i < sizes;i++) {
+    static const UBYTE precisions[] = {8,12,16};
+    char name[64];
+    int p;
+    
+    sprintf(name,"synthetic-%lux%lu",(unsigned long)widths[i],(unsigned long)heights[i]);
+    for(p = 0;p < int(sizeof(precisions));p++) {
+      struct BenchImage img;
+      const struct Workload *wl;
+      
+      if (!AllocImage(&img,name,widths[i],heights[i],depth,precisions[p])) {
+        fprintf(stderr,"%s: out of memory\n",name);
+        failures++;
+        continue;
+      }
+      GenerateImage(&img);
+      for(wl = Workloads;wl->wl_pName;wl++) {
+        if (wl->wl_ucPrecision != img.bi_ucPrecision)
+          continue;
+        if (filter && strstr(wl->wl_pName,filter) == NULL)
+          continue;
+        if (depth == 1 && (wl->wl_ucSubX != 1 || wl->wl_ucSubY != 1))
+          continue;
+        if (!RunWorkload(wl,&img,repetitions))
+          failures++;
+      }
+      free(img.bi_pMem);
+    }
+  }
+  //
+  // Run the corpus images on the workloads of their precision.
+  for(i = 0;i < nfiles;i++) {
+    struct BenchImage img;
+    const struct Workload *wl;
+    bool found = false;
+    
+    if (!LoadImage(&img,files[i])) {
+      failures++;
+      continue;
+    }
+    for(wl = Workloads;wl->wl_pName;wl++) {
+      if (wl->wl_ucPrecision != img.bi_ucPrecision)
+        continue;
+      found = true;
+      if (filter && strstr(wl->wl_pName,filter) == NULL)
+        continue;
+      if (img.bi_ucDepth == 1 && (wl->wl_ucSubX != 1 || wl->wl_ucSubY != 1))
+        continue;
+      if (!RunWorkload(wl,&img,repetitions))
+        failures++;
+    }
+    if (!found)
+      fprintf(stderr,"%s: no workloads for a precision of %d bits\n",files[i],img.bi_ucPrecision);
+    free(img.bi_pMem);
+  }
+  
+  return (failures)?(20):(0);
+}
+///
@@ -160,6 +160,11 @@ class Box *Box::ParseBoxMarker(class Tables *tables,class Box *&boxlist,class By
     box->m_usEnumerator = en;
   }
   //
+  // Announce the remaining box data. It follows in this and the next
+  // APP11 markers, whose headers are not included here.
+  if (box->m_uqBoxSize - box->m_uqParsedBytes < MAX_ULONG)
+    stream->Prefetch(ULONG(box->m_uqBoxSize - box->m_uqParsedBytes));
+  //
   // Add the data to the input stream.
   box->InputStreamOf()->Append(stream,blen,z);
   box->m_uqParsedBytes += blen;
@@ -43,7 +43,7 @@
 FileTypeBox::~FileTypeBox(void)
 {
   if (m_pulCompatible) {
-    m_pEnviron->FreeMem(m_pulCompatible,sizeof(ULONG) * m_ulNumCompats);
+    m_pEnviron->FreeMem(m_pulCompatible,sizeof(ULONG) * m_ulNumCompats,JPGFLAG_MIO_BOXES);
   }
 }
 ///
@@ -92,7 +92,7 @@ bool FileTypeBox::ParseBoxContent(class ByteStream *stream,UQUAD boxsize)
   //
   cnt = boxsize >> 2;
   m_ulNumCompats  = cnt;
-  m_pulCompatible = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * cnt);
+  m_pulCompatible = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * cnt,JPGFLAG_MIO_BOXES);
   cmp = m_pulCompatible;
   while(cnt) {
     hi     = stream->GetWord();
@@ -142,11 +142,11 @@ void FileTypeBox::addCompatibility(ULONG compat)
     JPG_THROW(OVERFLOW_PARAMETER,"FileTypeBox::addCompatibility",
               "too many compatible brands specified, cannot add another");
 
-  p = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * newcnt);
+  p = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * newcnt,JPGFLAG_MIO_BOXES);
 
   if (m_pulCompatible && m_ulNumCompats > 0) {
     memcpy(p,m_pulCompatible,m_ulNumCompats * sizeof(ULONG));
-    m_pEnviron->FreeMem(m_pulCompatible,m_ulNumCompats * sizeof(ULONG));
+    m_pEnviron->FreeMem(m_pulCompatible,m_ulNumCompats * sizeof(ULONG),JPGFLAG_MIO_BOXES);
     m_pulCompatible = NULL;
   }
 
@@ -45,13 +45,13 @@
 FloatToneMappingBox::~FloatToneMappingBox(void)
 {
   if (m_pfTable)
-    m_pEnviron->FreeMem(m_pfTable,m_ulTableEntries * sizeof(FLOAT));
+    m_pEnviron->FreeMem(m_pfTable,m_ulTableEntries * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
 
   if (m_plInverseMapping)
-    m_pEnviron->FreeMem(m_plInverseMapping,(1UL << (8 + m_ucResidualBits)) * sizeof(LONG));
+    m_pEnviron->FreeMem(m_plInverseMapping,(1UL << (8 + m_ucResidualBits)) * sizeof(LONG),JPGFLAG_MIO_BOXES);
 
   if (m_pfInterpolated)
-    m_pEnviron->FreeMem(m_pfInterpolated,(m_ulTableEntries << m_ucFractionalBits) * sizeof(FLOAT));
+    m_pEnviron->FreeMem(m_pfInterpolated,(m_ulTableEntries << m_ucFractionalBits) * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
 }
 ///
 
@@ -92,7 +92,7 @@ bool FloatToneMappingBox::ParseBoxContent(class ByteStream *stream,UQUAD boxsize
   assert(m_pfTable == NULL);
 
   m_ulTableEntries = entries;
-  dt = m_pfTable   = (FLOAT *)(m_pEnviron->AllocMem(entries * sizeof(FLOAT)));
+  dt = m_pfTable   = (FLOAT *)(m_pEnviron->AllocMem(entries * sizeof(FLOAT),JPGFLAG_MIO_BOXES));
   
   while(entries) {
     LONG hi = stream->GetWord();
@@ -140,7 +140,7 @@ void FloatToneMappingBox::DefineTable(UBYTE tableidx,const FLOAT *table,ULONG si
   assert((size & (size - 1)) == 0);
   assert(size);
 
-  m_pfTable        = (FLOAT *)m_pEnviron->AllocMem(size * sizeof(FLOAT));
+  m_pfTable        = (FLOAT *)m_pEnviron->AllocMem(size * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
   m_ulTableEntries = size;
   for(i = 0;i < size;i++)
     m_pfTable[i]   = table[i];
@@ -236,7 +236,7 @@ const LONG *FloatToneMappingBox::InverseScaledTableOf(UBYTE dctbits,UBYTE spatia
     LONG inmax  = (1L << (dctbits     + dctfract    )) - 1;
     bool lastfilled;
     
-    m_plInverseMapping = (LONG *)m_pEnviron->AllocMem((1 << (spatialbits + spatialfract)) * sizeof(LONG));
+    m_plInverseMapping = (LONG *)m_pEnviron->AllocMem((1 << (spatialbits + spatialfract)) * sizeof(LONG),JPGFLAG_MIO_BOXES);
     // Not guaranteed that the mapping is surjective onto the output
     // range. There is nothing that says how to handle this case. We just define
     // "undefined" outputs to zero, and try our best to continue the missing parts
@@ -374,7 +374,7 @@ const FLOAT *FloatToneMappingBox::UpscaleTable(UBYTE inputbits,UBYTE outputbits,
   // Here we must build that anew.
   m_ucFractionalBits = infract;
   fullsize           = m_ulTableEntries << infract;
-  m_pfInterpolated   = (FLOAT *)m_pEnviron->AllocMem(fullsize * sizeof(FLOAT));
+  m_pfInterpolated   = (FLOAT *)m_pEnviron->AllocMem(fullsize * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
   scale              = 1.0 / (1 << infract);
 
   assert(m_pfTable);
@@ -43,10 +43,10 @@
 InverseToneMappingBox::~InverseToneMappingBox(void)
 {
   if (m_plTable)
-    m_pEnviron->FreeMem(m_plTable,m_ulTableEntries * sizeof(LONG));
+    m_pEnviron->FreeMem(m_plTable,m_ulTableEntries * sizeof(LONG),JPGFLAG_MIO_BOXES);
 
   if (m_plInverseMapping)
-    m_pEnviron->FreeMem(m_plInverseMapping,(1UL << (8 + m_ucResidualBits)) * sizeof(LONG));
+    m_pEnviron->FreeMem(m_plInverseMapping,(1UL << (8 + m_ucResidualBits)) * sizeof(LONG),JPGFLAG_MIO_BOXES);
 }
 ///
 
@@ -83,7 +83,7 @@ bool InverseToneMappingBox::ParseBoxContent(class ByteStream *stream,UQUAD boxsi
   assert(m_plTable == NULL);
 
   m_ulTableEntries = entries;
-  dt = m_plTable   = (LONG *)(m_pEnviron->AllocMem(entries * sizeof(LONG)));
+  dt = m_plTable   = (LONG *)(m_pEnviron->AllocMem(entries * sizeof(LONG),JPGFLAG_MIO_BOXES));
   
   if (m_ucResidualBits <= 8) {
     while(entries) {
@@ -144,7 +144,7 @@ void InverseToneMappingBox::DefineTable(UBYTE tableidx,const UWORD *table,ULONG
   assert((size & (size - 1)) == 0);
   assert(size);
 
-  m_plTable        = (LONG *)m_pEnviron->AllocMem(size * sizeof(LONG));
+  m_plTable        = (LONG *)m_pEnviron->AllocMem(size * sizeof(LONG),JPGFLAG_MIO_BOXES);
   m_ulTableEntries = size;
   for(i = 0;i < size;i++)
     m_plTable[i]   = table[i];
@@ -228,7 +228,7 @@ const LONG *InverseToneMappingBox::InverseScaledTableOf(UBYTE dctbits,UBYTE spat
     LONG inmax  = (1L << (dctbits     + dctfract))     - 1;
     bool lastfilled;
     
-    m_plInverseMapping = (LONG *)m_pEnviron->AllocMem((1 << (spatialbits + spatialfract)) * sizeof(LONG));
+    m_plInverseMapping = (LONG *)m_pEnviron->AllocMem((1 << (spatialbits + spatialfract)) * sizeof(LONG),JPGFLAG_MIO_BOXES);
     // Nnot guaranteed that the mapping is surjective onto the output
     // range. There is nothing that says how to handle this case. We just define
     // "undefined" outputs to zero, and try our best to continue the missing parts
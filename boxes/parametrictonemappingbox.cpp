@@ -50,13 +50,13 @@ ParametricToneMappingBox::~ParametricToneMappingBox(void)
     m_pImpls = impl->m_pNext;
     
     if (impl->m_plTable)
-      m_pEnviron->FreeMem(impl->m_plTable,impl->m_ulTableEntries * sizeof(LONG)); 
+      m_pEnviron->FreeMem(impl->m_plTable,impl->m_ulTableEntries * sizeof(LONG),JPGFLAG_MIO_BOXES); 
 
     if (impl->m_pfTable)
-      m_pEnviron->FreeMem(impl->m_pfTable,impl->m_ulTableEntries * sizeof(FLOAT));
+      m_pEnviron->FreeMem(impl->m_pfTable,impl->m_ulTableEntries * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
 
     if (impl->m_plInverseTable)
-      m_pEnviron->FreeMem(impl->m_plInverseTable,impl->m_ulInverseTableEntries * sizeof(LONG));
+      m_pEnviron->FreeMem(impl->m_plInverseTable,impl->m_ulInverseTableEntries * sizeof(LONG),JPGFLAG_MIO_BOXES);
 
     delete impl;
   }
@@ -389,7 +389,7 @@ const LONG *ParametricToneMappingBox::ScaledTableOf(UBYTE inputbits,UBYTE output
     assert(impl->m_ulTableEntries == 0 || impl->m_ulTableEntries == max);
     
     impl->m_ulTableEntries = max;
-    impl->m_plTable        = (LONG *)m_pEnviron->AllocMem(max * sizeof(LONG));
+    impl->m_plTable        = (LONG *)m_pEnviron->AllocMem(max * sizeof(LONG),JPGFLAG_MIO_BOXES);
 
     do {
       LONG out = LONG(floor(outscale * TableValue(i * inscale)+0.5));
@@ -434,7 +434,7 @@ const FLOAT *ParametricToneMappingBox::FloatTableOf(UBYTE inputbits,UBYTE output
     assert(impl->m_ulTableEntries == 0 || impl->m_ulTableEntries == max);
     
     impl->m_ulTableEntries = max;
-    impl->m_pfTable        = (FLOAT *)m_pEnviron->AllocMem(max * sizeof(FLOAT));
+    impl->m_pfTable        = (FLOAT *)m_pEnviron->AllocMem(max * sizeof(FLOAT),JPGFLAG_MIO_BOXES);
 
     do {
       FLOAT out = outscale * TableValue(i * inscale);
@@ -482,7 +482,7 @@ const LONG *ParametricToneMappingBox::ExtendedInverseScaledTableOf(UBYTE dctbits
     assert(spatialbits <= 16);
 
     impl->m_ulInverseTableEntries = max;
-    impl->m_plInverseTable        = (LONG *)m_pEnviron->AllocMem(max * sizeof(LONG));
+    impl->m_plInverseTable        = (LONG *)m_pEnviron->AllocMem(max * sizeof(LONG),JPGFLAG_MIO_BOXES);
 
     do {
       LONG out = LONG(floor(outscale * InverseTableValue((i - LONG(offset)) * inscale)+0.5));
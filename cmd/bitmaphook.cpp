@@ -153,37 +153,47 @@ JPG_LONG BitmapHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
                 ULONG count = bmm->bmm_ulWidth * height * bmm->bmm_usDepth;
                 FLOAT *data = (FLOAT *)bmm->bmm_pMemPtr;
                 UBYTE *ldr  = (UBYTE *)bmm->bmm_pLDRMemPtr;
+                bool tmo    = bmm->bmm_pLDRMemPtr && bmm->bmm_pLDRSource == NULL;
+                // Read the stripe in one go, then post-process in memory.
+                readFloats(bmm->bmm_pSource,data,count,bmm->bmm_bBigEndian);
                 do {
-                  double in = readFloat(bmm->bmm_pSource,bmm->bmm_bBigEndian);
-                  UWORD half;
-                  if (bmm->bmm_bClamp && in < 0.0)
-                    in = 0.0; 
-                  half = DoubleToHalf(in);
+                  FLOAT in = *data;
+                  if (bmm->bmm_bClamp && in < 0.0f)
+                    in = 0.0f; 
                   // Tone-map the input unless there is an LDR source.
-                  if (bmm->bmm_pLDRMemPtr && bmm->bmm_pLDRSource == NULL)
-                    *ldr  = bmm->bmm_HDR2LDR[half];
-                  *data = FLOAT(in);
+                  if (tmo)
+                    *ldr  = bmm->bmm_HDR2LDR[FloatToHalf(in)];
+                  *data = in;
                   data++,ldr++;
                 } while(--count);
               } else {
                 ULONG count = bmm->bmm_ulWidth * height * bmm->bmm_usDepth;
                 UWORD *data = (UWORD *)bmm->bmm_pMemPtr;
                 UBYTE *ldr  = (UBYTE *)bmm->bmm_pLDRMemPtr;
+                bool tmo    = bmm->bmm_pLDRMemPtr && bmm->bmm_pLDRSource == NULL;
+                FLOAT buffer[256];
+                // Read the stripe in chunks, then convert in memory.
                 do {
-                  double in = readFloat(bmm->bmm_pSource,bmm->bmm_bBigEndian);
-                  if (bmm->bmm_bClamp && in < 0.0)
-                    in = 0.0;
-                  *data = DoubleToHalf(in);
-                  // Tone-map the input unless there is an LDR source.
-                  if (bmm->bmm_pLDRMemPtr && bmm->bmm_pLDRSource == NULL) {
-                    if (in >= 0.0) {
-                      *ldr  = bmm->bmm_HDR2LDR[*data];
-                    } else {
-                      *ldr  = 0;
+                  ULONG chunk = (count > 256)?(256):(count);
+                  FLOAT *src  = buffer;
+                  readFloats(bmm->bmm_pSource,buffer,chunk,bmm->bmm_bBigEndian);
+                  count -= chunk;
+                  do {
+                    FLOAT in = *src++;
+                    if (bmm->bmm_bClamp && in < 0.0f)
+                      in = 0.0f;
+                    *data = FloatToHalf(in);
+                    // Tone-map the input unless there is an LDR source.
+                    if (tmo) {
+                      if (in >= 0.0f) {
+                        *ldr  = bmm->bmm_HDR2LDR[*data];
+                      } else {
+                        *ldr  = 0;
+                      }
                     }
-                  }
-                  data++,ldr++;
-                } while(--count);
+                    data++,ldr++;
+                  } while(--chunk);
+                } while(count);
               }
             } else {
               fread(bmm->bmm_pMemPtr,bmm->bmm_ucPixelType & CTYP_SIZE_MASK,
@@ -238,43 +248,32 @@ JPG_LONG BitmapHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
           if (bmm->bmm_pTarget) {
             if (bmm->bmm_bFloat) {
               if (bmm->bmm_bNoOutputConversion) {
-                ULONG count = bmm->bmm_ulWidth * height;
-                FLOAT *data = (FLOAT *)bmm->bmm_pMemPtr;
-                double r = 0.0,g = 0.0,b = 0.0; // shut up the compiler.
-                do {
-                  switch(bmm->bmm_usDepth) {
-                  case 1:
-                    writeFloat(bmm->bmm_pTarget,*data++,bmm->bmm_bBigEndian);
-                    break;
-                  case 3:
-                    r = *data++;
-                    g = *data++;
-                    b = *data++;
-                    writeFloat(bmm->bmm_pTarget,r,bmm->bmm_bBigEndian);
-                    writeFloat(bmm->bmm_pTarget,g,bmm->bmm_bBigEndian);
-                    writeFloat(bmm->bmm_pTarget,b,bmm->bmm_bBigEndian);
-                    break;
-                  }
-                } while(--count);
+                switch(bmm->bmm_usDepth) {
+                case 1:
+                case 3: // Interleaved samples can be written in one go.
+                  writeFloats(bmm->bmm_pTarget,(const FLOAT *)bmm->bmm_pMemPtr,
+                              bmm->bmm_ulWidth * height * bmm->bmm_usDepth,bmm->bmm_bBigEndian);
+                  break;
+                }
               } else {
-                ULONG count = bmm->bmm_ulWidth * height;
-                UWORD *data = (UWORD *)bmm->bmm_pMemPtr;
-                double r = 0.0,g = 0.0,b = 0.0; // shut up the compiler.
-                do {
-                  switch(bmm->bmm_usDepth) {
-                  case 1:
-                    writeFloat(bmm->bmm_pTarget,HalfToDouble(*data++),bmm->bmm_bBigEndian);
-                    break;
-                  case 3:
-                    r = HalfToDouble(*data++);
-                    g = HalfToDouble(*data++);
-                    b = HalfToDouble(*data++);
-                    writeFloat(bmm->bmm_pTarget,r,bmm->bmm_bBigEndian);
-                    writeFloat(bmm->bmm_pTarget,g,bmm->bmm_bBigEndian);
-                    writeFloat(bmm->bmm_pTarget,b,bmm->bmm_bBigEndian);
-                    break;
+                switch(bmm->bmm_usDepth) {
+                case 1:
+                case 3: // Interleaved samples, convert in chunks and write in one go.
+                  {
+                    ULONG count = bmm->bmm_ulWidth * height * bmm->bmm_usDepth;
+                    UWORD *data = (UWORD *)bmm->bmm_pMemPtr;
+                    FLOAT buffer[256];
+                    do {
+                      ULONG chunk = (count > 256)?(256):(count);
+                      ULONG i;
+                      for(i = 0;i < chunk;i++)
+                        buffer[i] = FLOAT(HalfToDouble(*data++));
+                      writeFloats(bmm->bmm_pTarget,buffer,chunk,bmm->bmm_bBigEndian);
+                      count -= chunk;
+                    } while(count);
                   }
-                } while(--count);
+                  break;
+                }
               }
             } else {
               switch(bmm->bmm_usDepth) {
@@ -367,33 +366,39 @@ JPG_LONG AlphaHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
               if (bmm->bmm_bNoAlphaOutputConversion) {
                 ULONG count = bmm->bmm_ulWidth * height;
                 FLOAT *data = (FLOAT *)bmm->bmm_pAlphaPtr;
-                do {
-                  double in = readFloat(bmm->bmm_pAlphaSource,bmm->bmm_bAlphaBigEndian);
-                  if (bmm->bmm_bAlphaClamp) {
-                    if (in < 0.0)
-                      in = 0.0; 
-                    if (in > 1.0)
-                      in = 1.0;
-                  }
-                  // No LDR mapping here.
-                  *data = FLOAT(in);
-                  data++;
-                } while(--count);
+                readFloats(bmm->bmm_pAlphaSource,data,count,bmm->bmm_bAlphaBigEndian);
+                if (bmm->bmm_bAlphaClamp) {
+                  do {
+                    if (*data < 0.0f)
+                      *data = 0.0f; 
+                    if (*data > 1.0f)
+                      *data = 1.0f;
+                    // No LDR mapping here.
+                    data++;
+                  } while(--count);
+                }
               } else {
                 ULONG count = bmm->bmm_ulWidth * height;
                 UWORD *data = (UWORD *)bmm->bmm_pAlphaPtr;
+                FLOAT buffer[256];
                 do {
-                  double in = readFloat(bmm->bmm_pAlphaSource,bmm->bmm_bAlphaBigEndian);
-                  if (bmm->bmm_bAlphaClamp) {
-                    if (in < 0.0)
-                      in = 0.0;
-                    if (in > 1.0)
-                      in = 1.0;
-                  }
-                  *data = DoubleToHalf(in);
-                  // No TMO here.
-                  data++;
-                } while(--count);
+                  ULONG chunk = (count > 256)?(256):(count);
+                  FLOAT *src  = buffer;
+                  readFloats(bmm->bmm_pAlphaSource,buffer,chunk,bmm->bmm_bAlphaBigEndian);
+                  count -= chunk;
+                  do {
+                    FLOAT in = *src++;
+                    if (bmm->bmm_bAlphaClamp) {
+                      if (in < 0.0f)
+                        in = 0.0f;
+                      if (in > 1.0f)
+                        in = 1.0f;
+                    }
+                    *data = FloatToHalf(in);
+                    // No TMO here.
+                    data++;
+                  } while(--chunk);
+                } while(count);
               }
             } else {
               fread(bmm->bmm_pAlphaPtr,bmm->bmm_ucAlphaType & CTYP_SIZE_MASK,
@@ -429,17 +434,20 @@ JPG_LONG AlphaHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
           if (bmm->bmm_pAlphaTarget) {
             if (bmm->bmm_bAlphaFloat) {
               if (bmm->bmm_bNoAlphaOutputConversion) {
-                ULONG count = bmm->bmm_ulWidth * height;
-                FLOAT *data = (FLOAT *)bmm->bmm_pAlphaPtr;
-                do {
-                  writeFloat(bmm->bmm_pAlphaTarget,*data++,bmm->bmm_bAlphaBigEndian);
-                } while(--count);
+                writeFloats(bmm->bmm_pAlphaTarget,(const FLOAT *)bmm->bmm_pAlphaPtr,
+                            bmm->bmm_ulWidth * height,bmm->bmm_bAlphaBigEndian);
               } else {
                 ULONG count = bmm->bmm_ulWidth * height;
                 UWORD *data = (UWORD *)bmm->bmm_pAlphaPtr;
+                FLOAT buffer[256];
                 do {
-                  writeFloat(bmm->bmm_pAlphaTarget,HalfToDouble(*data++),bmm->bmm_bAlphaBigEndian);
-                } while(--count);
+                  ULONG chunk = (count > 256)?(256):(count);
+                  ULONG i;
+                  for(i = 0;i < chunk;i++)
+                    buffer[i] = FLOAT(HalfToDouble(*data++));
+                  writeFloats(bmm->bmm_pAlphaTarget,buffer,chunk,bmm->bmm_bAlphaBigEndian);
+                  count -= chunk;
+                } while(count);
               }
             } else {
 #ifdef JPG_LIL_ENDIAN
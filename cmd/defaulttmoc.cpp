@@ -41,6 +41,7 @@
 #include "cmd/iohelpers.hpp"
 #include "std/stdio.hpp"
 #include "std/math.hpp"
+#include "std/stdlib.hpp"
 ///
 
 /// BuildToneMapping_C
@@ -51,7 +52,8 @@
 // Erik Reinhard and Kate Devlin. Dynamic Range Reduction Inspired by
 // Photoreceptor Physiology.  IEEE Transactions on Visualization and
 // Computer Graphics (2004).
-void BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemapping[65536],
+// Returns false if the source image could not be read.
+bool BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemapping[65536],
                         bool flt,bool bigendian,bool xyz,int hiddenbits)
 {
   long pos    = ftell(in);
@@ -66,13 +68,24 @@ void BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemappi
   double maxy =-HUGE_VAL;
   double m;
   long cnt = 0;
+  bool failed = false;
+  UBYTE *row  = (UBYTE *)malloc(PNMRowSize(w,depth,count,flt));
 
-  for(y = 0;y < h;y++) {
-    for(x = 0;x < w;x++) {
+  if (row == NULL) {
+    fprintf(stderr,"Out of memory building the tone mapping\n");
+    return false;
+  }
+
+  for(y = 0;y < h && !failed;y++) {
+    if (!ReadPNMRow(in,row,w,depth,count,flt,bigendian)) {
+      failed = true;
+      break;
+    }
+    for(x = 0;x < w && !failed;x++) {
       int r,g,b;
       double y;
 
-      ReadRGBTriple(in,r,g,b,y,depth,count,flt,bigendian,xyz);
+      ConvertRGBTriple(row,x,r,g,b,y,depth,count,flt,xyz,failed);
 
       if (y > 0.0) {
         double logy = log(y);
@@ -91,6 +104,11 @@ void BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemappi
     }
   }
 
+  free(row);
+
+  if (failed)
+    return false;
+
   lav  /= cnt;
   llav /= cnt;
   if (maxl <= minl) {
@@ -122,5 +140,7 @@ void BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemappi
       tonemapping[i] = in;
     }
   }
+
+  return true;
 }
 ///
@@ -45,7 +45,7 @@
 ///
 
 /// Prototypes
-extern void BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemapping[65536],
+extern bool BuildToneMapping_C(FILE *in,int w,int h,int depth,int count,UWORD tonemapping[65536],
                                bool flt,bool bigendian,bool xyz,int hiddenbits);
 ///
 
@@ -43,6 +43,7 @@
 #include "cmd/filehook.hpp"
 #include "cmd/bitmaphook.hpp"
 #include "cmd/iohelpers.hpp"
+#include "cmd/scans.hpp"
 #include "tools/numerics.hpp"
 #include "tools/traits.hpp"
 #include "std/stdio.hpp"
@@ -55,78 +56,32 @@
 ///
 
 /// EncodeC
-void EncodeC(const char *source,const char *ldrsource,const char *target,const char *ltable,
-             int quality,int hdrquality,
-             int tabletype,int residualtt,int maxerror,
-             int colortrafo,bool lossless,bool progressive,
-             bool residual,bool optimize,bool accoding,
-             bool rsequential,bool rprogressive,bool raccoding,
-             bool dconly,UBYTE levels,bool pyramidal,bool writednl,UWORD restart,double gamma,
-             int lsmode,bool noiseshaping,bool serms,bool losslessdct,bool dctbypass,
-             bool openloop,bool deadzone,bool xyz,bool cxyz,
-             int hiddenbits,int riddenbits,int resprec,bool separate,
-             bool median,int smooth,bool noclamp,
-             const char *sub,const char *ressub,
-             const char *alpha,int alphamode,int matte_r,int matte_g,int matte_b,
-             bool alpharesiduals,int alphaquality,int alphahdrquality,
-             int alphatt,int residualalphatt,
-             int ahiddenbits,int ariddenbits,int aresprec,
-             bool aopenloop,bool adeadzone,bool aserms,bool abypass)
+// Encode an image in profile C. Returns zero on success, or the exit
+// code of the program on failure.
+int EncodeC(const char *source,const char *ldrsource,const char *target,const char *ltable,
+            int quality,int hdrquality,
+            int tabletype,int residualtt,int maxerror,
+            int colortrafo,bool lossless,bool progressive,
+            bool residual,bool optimize,bool accoding,
+            bool rsequential,bool rprogressive,bool raccoding,
+            bool dconly,UBYTE levels,bool pyramidal,bool writednl,UWORD restart,bool stream,double gamma,
+            int lsmode,bool noiseshaping,bool serms,bool losslessdct,bool dctbypass,
+            bool openloop,bool deadzone,int rdo,bool xyz,bool cxyz,
+            int hiddenbits,int riddenbits,int resprec,bool separate,
+            bool median,int smooth,bool noclamp,
+            const char *sub,const char *ressub,
+            const char *alpha,int alphamode,int matte_r,int matte_g,int matte_b,
+            bool alpharesiduals,int alphaquality,int alphahdrquality,
+            int alphatt,int residualalphatt,
+            int ahiddenbits,int ariddenbits,int aresprec,
+            bool aopenloop,bool adeadzone,bool aserms,bool abypass)
 { 
+  int rc = 0;
   struct JPG_TagItem dcscan[] = { // scan parameters for the first DCOnly scan
     JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,0),
     JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,0),
     JPG_EndTag
   };
-  struct JPG_TagItem pscan1[] = { // standard progressive scan, first scan.
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,0),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,0),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
-    JPG_EndTag
-  };
-  struct JPG_TagItem pscan2[] = {
-    JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,5),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,2), 
-    JPG_EndTag
-  };
-  struct JPG_TagItem pscan3[] = {
-    JPG_ValueTag(JPGTAG_SCAN_COMPONENTS_CHROMA,0),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
-    JPG_EndTag
-  };
-  struct JPG_TagItem pscan4[] = {
-    JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0), 
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,6),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,2),
-    JPG_EndTag
-  }; 
-  struct JPG_TagItem pscan5[] = {
-    JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0), 
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,2),
-    JPG_EndTag
-  };  
-  struct JPG_TagItem pscan6[] = {
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,0),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,0),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,0),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,1),
-    JPG_EndTag
-  };
-  struct JPG_TagItem pscan7[] = {
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
-    JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,0),
-    JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,1),
-    JPG_EndTag
-  };
 
   struct JPG_TagItem rscan1[] = { // residual progressive scan, first scan.
     JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,6),
@@ -244,14 +199,20 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
         } else {
           if (gamma <= 0.0) {
             if (ldrin != NULL) {
+              bool ok;
               if (separate) {
-                BuildRGBToneMappingFromLDR(in,ldrin,width,height,prec,depth,
-                                           red,green,blue,flt,big,xyz || cxyz,hiddenbits,
-                                           median,fullrange,smooth);
+                ok = BuildRGBToneMappingFromLDR(in,ldrin,width,height,prec,depth,
+                                                red,green,blue,flt,big,xyz || cxyz,hiddenbits,
+                                                median,fullrange,smooth);
               } else {
-                BuildToneMappingFromLDR(in,ldrin,width,height,prec,depth,
-                                        ldrtohdr,flt,big,xyz || cxyz,hiddenbits,
-                                        median,fullrange,smooth);
+                ok = BuildToneMappingFromLDR(in,ldrin,width,height,prec,depth,
+                                             ldrtohdr,flt,big,xyz || cxyz,hiddenbits,
+                                             median,fullrange,smooth);
+              }
+              if (!ok) {
+                fclose(ldrin);
+                fclose(in);
+                return 20;
               }
               if (hiddenbits)
                 printf("\n"
@@ -262,7 +223,10 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
               if (separate)
                 printf("Warning: -sp switch ignored, only one TMO will be used");
               separate = false; // Still to be done.
-              BuildToneMapping_C(in,width,height,prec,depth,ldrtohdr,flt,big,xyz || cxyz,hiddenbits);
+              if (!BuildToneMapping_C(in,width,height,prec,depth,ldrtohdr,flt,big,xyz || cxyz,hiddenbits)) {
+                fclose(in);
+                return 20;
+              }
             }
           } else {
             BuildGammaMapping(gamma,1.0,ldrtohdr,flt,(1L << prec) - 1,hiddenbits);
@@ -411,28 +375,28 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
                           residualtype == JPGFLAG_RESIDUALPROGRESSIVE)?
                          JPGFLAG_TONEMAPPING_LUT:JPGFLAG_TONEMAPPING_IDENTITY),
             // Define the scan parameters for progressive.
-            JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,(dconly)?(dcscan):(pscan1)),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan2),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan3),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan4),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan5),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan6),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan7),
+            JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,(dconly)?(dcscan):(ProgressiveScan1)),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan2),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan3),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan4),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan5),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan6),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan7),
             
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan1:pscan1),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan1:ProgressiveScan1),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan2:pscan2),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan2:ProgressiveScan2),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan3:pscan3),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan3:ProgressiveScan3),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan4:pscan4),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan4:ProgressiveScan4),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan5:pscan5),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan5:ProgressiveScan5),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan6:pscan6),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan6:ProgressiveScan6),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan7:pscan7),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan7:ProgressiveScan7),
             JPG_ValueTag(JPGTAG_IMAGE_IS_FLOAT,alphaflt),
             JPG_ValueTag(JPGTAG_IMAGE_OUTPUT_CONVERSION,alphaflt),
             JPG_EndTag
@@ -442,7 +406,8 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
             JPG_PointerTag(JPGTAG_BIH_HOOK,&bmhook),
             JPG_PointerTag((alpha)?JPGTAG_BIH_ALPHAHOOK:JPGTAG_TAG_IGNORE,&alphahook),
             JPG_PointerTag((residual && hiddenbits == 0 && ldrin)?JPGTAG_BIH_LDRHOOK:JPGTAG_TAG_IGNORE,&ldrhook),
-            JPG_ValueTag(JPGTAG_ENCODER_LOOP_ON_INCOMPLETE,true),
+            JPG_ValueTag(JPGTAG_ENCODER_LOOP_ON_INCOMPLETE,!stream),
+            JPG_ValueTag(JPGTAG_ENCODER_IMAGE_COMPLETE,false),
             JPG_ValueTag(JPGTAG_IMAGE_WIDTH,width), 
             JPG_ValueTag(JPGTAG_IMAGE_HEIGHT,height), 
             JPG_ValueTag(JPGTAG_IMAGE_DEPTH,depth),      
@@ -472,6 +437,7 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
             JPG_PointerTag(JPGTAG_RESIDUAL_SUBY,ressuby),
             JPG_ValueTag(JPGTAG_OPENLOOP_ENCODER,openloop),
             JPG_ValueTag(JPGTAG_DEADZONE_QUANTIZER,deadzone),
+            JPG_ValueTag(JPGTAG_OPTIMIZE_QUANTIZER,rdo),
             JPG_ValueTag(JPGTAG_RESIDUAL_PRECISION,resprec),
             // The RGB2XYZ transformation matrix, used as L-transformation if the xyz flag is true.
             // this is the product of the 601->RGB and RGB->XYZ matrix
@@ -533,28 +499,28 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
             JPG_ValueTag((fullrange)?(JPGTAG_TONEMAPPING_R2_TYPE(2)):JPGTAG_TAG_IGNORE,
                          JPGFLAG_TONEMAPPING_LINEAR), 
             // The default settings for R2 in profile C are quite ok.
-            JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,(dconly)?(dcscan):(pscan1)),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan2),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan3),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan4),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan5),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan6),
-            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,pscan7),
+            JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,(dconly)?(dcscan):(ProgressiveScan1)),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan2),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan3),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan4),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan5),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan6),
+            JPG_PointerTag((progressive && !dconly)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan7),
             
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan1:pscan1),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan1:ProgressiveScan1),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan2:pscan2),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan2:ProgressiveScan2),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan3:pscan3),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan3:ProgressiveScan3),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan4:pscan4),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan4:ProgressiveScan4),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan5:pscan5),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan5:ProgressiveScan5),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan6:pscan6),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan6:ProgressiveScan6),
             JPG_PointerTag((rprogressive)?JPGTAG_RESIDUAL_SCAN:JPGTAG_TAG_IGNORE,
-                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan7:pscan7),
+                           ((residualtype & 7) == JPGFLAG_RESIDUALPROGRESSIVE)?rscan7:ProgressiveScan7),
             JPG_ValueTag((lsmode >= 0)?JPGTAG_SCAN_LS_INTERLEAVING:JPGTAG_TAG_IGNORE,lsmode),
             JPG_ValueTag(JPGTAG_IMAGE_IS_FLOAT,flt),
             JPG_ValueTag(JPGTAG_IMAGE_OUTPUT_CONVERSION,flt),
@@ -620,16 +586,23 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
                 // get away with writing the image as it is
                 // pushed into the image, but then only a single
                 // scan is allowed. 
-                ok = jpeg->ProvideImage(tags);
+                struct JPG_Hook filehook(FileHook,out);
+                struct JPG_TagItem iotags[] = {
+                  JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&filehook),
+                  JPG_PointerTag(JPGTAG_HOOK_IOSTREAM,out),
+                  JPG_ValueTag(JPGTAG_ENCODER_STREAM,stream),
+                  JPG_EndTag
+                };
+                //
+                // In streaming mode, push eight lines at a time and write
+                // out whatever is ready after each of them.
+                do {
+                  ok = jpeg->ProvideImage(tags);
+                  if (ok && stream)
+                    ok = jpeg->Write(iotags);
+                } while(ok && stream && !tags->GetTagData(JPGTAG_ENCODER_IMAGE_COMPLETE));
                 
                 if (ok) {
-                  struct JPG_Hook filehook(FileHook,out);
-                  struct JPG_TagItem iotags[] = {
-                    JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&filehook),
-                    JPG_PointerTag(JPGTAG_HOOK_IOSTREAM,out),
-                    JPG_EndTag
-                  };
-                  
                   //
                   // Write in one go, could interrupt this on each frame,scan,line or MCU.
                   ok = jpeg->Write(iotags);
@@ -638,32 +611,41 @@ void EncodeC(const char *source,const char *ldrsource,const char *target,const c
                   const char *error;
                   int code = jpeg->LastError(error);
                   fprintf(stderr,"writing a JPEG file failed - error %d - %s\n",code,error);
+                  rc = 20;
                 }
                 if (alphamem)
                   free(alphamem);
               } else {
                 fprintf(stderr,"failed allocating a buffer for the alpha channel\n");
+                rc = 20;
               }
               free(mem);
             } else {
               fprintf(stderr,"failed allocating a buffer for the image\n");
+              rc = 20;
             }
             JPEG::Destruct(jpeg);
           } else {
             fprintf(stderr,"failed to create a JPEG object\n");
+            rc = 20;
           }
         }
         fclose(out);
       } else {
         perror("unable to open the output file");
+        rc = 20;
       }
       if (alphain)
         fclose(alphain);
       if (ldrin)
         fclose(ldrin);
       fclose(in);
+    } else {
+      rc = 20;
     }
   }
+
+  return rc;
 }
 ///
 
@@ -76,6 +76,9 @@ JPG_LONG FileHook(struct JPG_Hook *hook, struct JPG_TagItem *tags)
     }
   case JPGFLAG_ACTION_QUERY:
     return 0;
+  case JPGFLAG_ACTION_PREFETCH:
+    // stdio buffers on its own, nothing to read ahead here.
+    return 0;
   }
   return -1;
 }
@@ -36,32 +36,132 @@
 #include "std/stdio.hpp"
 #include "std/math.hpp"
 #include "std/stdlib.hpp"
+#include "std/string.hpp"
 ///
 
-/// ReadRGBTriple
-// Read an RGB triple from the stream, convert properly.
-bool ReadRGBTriple(FILE *in,int &r,int &g,int &b,double &y,int depth,int count,
-                   bool flt,bool bigendian,bool xyz)
+/// SwapFloats
+// Convert the byte order of the given floating point numbers from or
+// to the file byte order if it differs from that of the host.
+static void SwapFloats(ULONG *data,ULONG count,bool bigendian)
+{
+#ifdef JPG_LIL_ENDIAN
+  if (!bigendian)
+    return;
+#else
+  if (bigendian)
+    return;
+#endif
+  while(count) {
+    ULONG v = *data;
+    *data++ = (v >> 24) | ((v >> 8) & 0xff00) | ((v & 0xff00) << 8) | (v << 24);
+    count--;
+  }
+}
+///
+
+/// readFloats
+// Read count IEEE floating point numbers from a PFM file in one go
+// into the given buffer. Returns false and fills the remaining numbers
+// with NaNs in case the file ended prematurely.
+bool readFloats(FILE *in,FLOAT *data,ULONG count,bool bigendian)
+{
+  size_t read = fread(data,sizeof(FLOAT),count,in);
+
+  SwapFloats((ULONG *)data,read,bigendian);
+
+  if (read < count) {
+    FLOAT *end = data + count;
+    data += read;
+    while(data < end)
+      *data++ = FLOAT(nan(""));
+    return false;
+  }
+  return true;
+}
+///
+
+/// writeFloats
+// Write count floating point numbers to a file in one go.
+void writeFloats(FILE *out,const FLOAT *data,ULONG count,bool bigendian)
+{
+  ULONG buffer[256];
+
+  while(count) {
+    ULONG chunk = (count > sizeof(buffer) / sizeof(ULONG))?(sizeof(buffer) / sizeof(ULONG)):(count);
+    memcpy(buffer,data,chunk * sizeof(FLOAT));
+    SwapFloats(buffer,chunk,bigendian);
+    fwrite(buffer,sizeof(FLOAT),chunk,out);
+    data  += chunk;
+    count -= chunk;
+  }
+}
+///
+
+/// PNMRowSize
+// Return the number of bytes a row of w pixels with count components
+// each takes in a PNM or PFM file.
+size_t PNMRowSize(int w,int depth,int count,bool flt)
+{
+  size_t bytes = (flt)?(sizeof(FLOAT)):((depth <= 8)?(1):(2));
+
+  return bytes * count * w;
+}
+///
+
+/// ReadPNMRow
+// Read a row of w pixels with count components each from the stream
+// in one go. The row buffer must hold PNMRowSize() bytes and must be
+// suitably aligned for floating point samples, which are brought into
+// host byte order. Returns false if the source ended prematurely.
+bool ReadPNMRow(FILE *in,UBYTE *row,int w,int depth,int count,bool flt,bool bigendian)
+{
+  bool ok;
+  
+  if (flt) {
+    ok = readFloats(in,(FLOAT *)row,ULONG(w) * count,bigendian);
+  } else {
+    size_t bytes = PNMRowSize(w,depth,count,flt);
+    ok = fread(row,1,bytes,in) == bytes;
+  }
+
+  if (!ok)
+    fprintf(stderr,"Error reading the source file\n");
+
+  return ok;
+}
+///
+
+/// ConvertRGBTriple
+// Convert pixel x of a row read by ReadPNMRow to an RGB triple. Returns
+// true if the samples had to be clamped, and sets the failed flag if the
+// source contains invalid samples.
+bool ConvertRGBTriple(const UBYTE *row,int x,int &r,int &g,int &b,double &y,int depth,int count,
+                      bool flt,bool xyz,bool &failed)
 { 
   bool warn = false;
   
+  r = g = b = 0;
+  y = 0.0;
+  
   // Read the HDR image parameters.
   if (count == 3) {
     if (flt) { 
+      const FLOAT *rgbf = (const FLOAT *)row + 3 * x;
       double rf,gf,bf;
       if (xyz) {
         double xf,yf,zf;
         // Convert from XYZ to RGB (the same colorspace as the LDR)
-        xf = readFloat(in,bigendian);
-        yf = readFloat(in,bigendian);
-        zf = readFloat(in,bigendian); 
+        xf = rgbf[0];
+        yf = rgbf[1];
+        zf = rgbf[2];
         if (xf < 0.0) xf = 0.0, warn = true;
         if (yf < 0.0) yf = 0.0, warn = true;
         if (zf < 0.0) zf = 0.0, warn = true;
         //
         if (isnan(zf)) {
           fprintf(stderr,"Error reading the source file\n");
-          exit(20);
+          failed = true;
+          return warn;
         }
         //
         // Convert from XYZ to RGB (the same colorspace as the LDR)
@@ -69,16 +169,17 @@ bool ReadRGBTriple(FILE *in,int &r,int &g,int &b,double &y,int depth,int count,
         gf = xf * -0.9692660 + yf *  1.8760108 + zf *  0.0415560;
         bf = xf *  0.0556434 + yf * -0.2040259 + zf *  1.0570000;
       } else { 
-        rf = readFloat(in,bigendian);
-        gf = readFloat(in,bigendian);
-        bf = readFloat(in,bigendian);
+        rf = rgbf[0];
+        gf = rgbf[1];
+        bf = rgbf[2];
         //
         if (rf < 0.0) rf = 0.0, warn = true;
         if (gf < 0.0) gf = 0.0, warn = true;
         if (bf < 0.0) bf = 0.0, warn = true;
         if (isnan(bf)) {
           fprintf(stderr,"Error reading the source file\n");
-          exit(20);
+          failed = true;
+          return warn;
         }
       }
       y  = (0.2126 * rf + 0.7152 * gf + 0.0722 * bf);
@@ -89,20 +190,18 @@ bool ReadRGBTriple(FILE *in,int &r,int &g,int &b,double &y,int depth,int count,
       int max = (1l << depth) - 1;
       // Integer samples, three components
       if (depth <= 8) {
-        r = getc(in);
-        g = getc(in);
-        b = getc(in);
+        const UBYTE *p = row + 3 * x;
+        r = p[0];
+        g = p[1];
+        b = p[2];
       } else {
-        r  = getc(in) << 8;
-        r |= getc(in);
-        g  = getc(in) << 8;
-        g |= getc(in);
-        b  = getc(in) << 8;
-        b |= getc(in);
-      }
-      if (b < 0) {
-        fprintf(stderr,"Error reading the source file\n");
-        exit(20);
+        const UBYTE *p = row + 6 * x;
+        r  = p[0] << 8;
+        r |= p[1];
+        g  = p[2] << 8;
+        g |= p[3];
+        b  = p[4] << 8;
+        b |= p[5];
       }
       y  = (0.2126 * r + 0.7152 * g + 0.0722 * b) / max;
       if (xyz) {
@@ -125,16 +224,16 @@ bool ReadRGBTriple(FILE *in,int &r,int &g,int &b,double &y,int depth,int count,
   } else {
     if (flt) {
       double gf;
-      gf = readFloat(in,bigendian);
+      gf = ((const FLOAT *)row)[x];
       if (gf < 0.0) gf = 0.0, warn = true;
       g  = DoubleToHalf(gf);
       y  = gf;
     } else {
       if (depth <= 8) {
-        g  = getc(in);
+        g  = row[x];
       } else {
-        g  = getc(in) << 8;
-        g |= getc(in);
+        g  = row[2 * x] << 8;
+        g |= row[2 * x + 1];
       }
       y = double(g) / ((1L << depth) - 1);
     }
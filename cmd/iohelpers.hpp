@@ -101,6 +101,52 @@ UWORD inline DoubleToHalf(double v)
 }
 ///
 
+/// FloatToHalf
+// Convert a single precision float to half-precision IEEE and return the
+// bit-pattern as a 16-bit unsigned integer. This operates on the bit
+// pattern directly and delivers the same result as DoubleToHalf, i.e.
+// the mantissa is truncated, not rounded.
+UWORD inline FloatToHalf(FLOAT f)
+{
+  union {
+    ULONG long_buf;
+    FLOAT float_buf;
+  } u;
+  ULONG sign,exponent,mantissa;
+
+  u.float_buf = f;
+  exponent    = (u.long_buf >> 23) & 0xff;
+  mantissa    = u.long_buf & ((1UL << 23) - 1);
+  //
+  if (exponent == 0xff) {
+    if (mantissa) // NaNs are left to the generic code.
+      return DoubleToHalf(f);
+    exponent = 31;
+  } else if (exponent == 0 && mantissa == 0) {
+    return 0; // also for -0.0 as this is not negative.
+  } else if (exponent >= 127 - 15 + 31) {
+    // Too large for a half float, becomes INF.
+    exponent = 31;
+    mantissa = 0;
+  } else if (exponent > 127 - 15) {
+    // A normalized half float.
+    exponent -= 127 - 15;
+    mantissa >>= 23 - 10;
+  } else {
+    // Denormalized or zero. Float denormals are always too small.
+    if (exponent > 127 - 1 - 32) {
+      mantissa = (mantissa | (1UL << 23)) >> (127 - 1 - exponent);
+    } else {
+      mantissa = 0;
+    }
+    exponent = 0;
+  }
+  sign = (u.long_buf >> 31)?(0x8000):(0x0000);
+  //
+  return UWORD(sign | (exponent << 10) | mantissa);
+}
+///
+
 /// readFloat
 // Read an IEEE floating point number from a PFM file
 double inline readFloat(FILE *in,bool bigendian)
@@ -156,8 +202,28 @@ void inline writeFloat(FILE *out,FLOAT f,bool bigendian)
 }
 ///
 
-// Read an RGB triple from the stream, convert properly.
-extern bool ReadRGBTriple(FILE *in,int &r,int &g,int &b,double &y,int depth,int count,bool flt,bool bigendian,bool xyz);
+// Read count IEEE floating point numbers from a PFM file in one go
+// into the given buffer. Returns false and fills the remaining numbers
+// with NaNs in case the file ended prematurely.
+extern bool readFloats(FILE *in,FLOAT *data,ULONG count,bool bigendian);
+//
+// Write count floating point numbers to a file in one go.
+extern void writeFloats(FILE *out,const FLOAT *data,ULONG count,bool bigendian);
+//
+// Return the number of bytes a row of w pixels with count components
+// each takes in a PNM or PFM file.
+extern size_t PNMRowSize(int w,int depth,int count,bool flt);
+//
+// Read a row of w pixels from the stream in one go into a buffer of
+// PNMRowSize() bytes, aligned for floats. Float samples are brought into
+// host byte order. Returns false if the source ended prematurely.
+extern bool ReadPNMRow(FILE *in,UBYTE *row,int w,int depth,int count,bool flt,bool bigendian);
+//
+// Convert pixel x of a row read by ReadPNMRow to an RGB triple. Returns
+// true if the samples had to be clamped, and sets the failed flag if the
+// source contains invalid samples.
+extern bool ConvertRGBTriple(const UBYTE *row,int x,int &r,int &g,int &b,double &y,int depth,int count,
+                             bool flt,bool xyz,bool &failed);
 //
 // Open a PPM/PFM file and return its dimensions and properties.
 extern FILE *OpenPNMFile(const char *file,int &width,int &height,int &depth,int &precision,bool &isfloat,bool &bigendian);
@@ -55,10 +55,20 @@
 #include "cmd/encodeb.hpp"
 #include "cmd/encodea.hpp"
 #include "cmd/reconstruct.hpp"
+#include "cmd/transcode.hpp"
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+#include <sys/time.h>
+#else
+#include <time.h>
+#endif
 ///
 
 /// Defines
 #define FIX_BITS 13
+// Maximum length of a line of a batch manifest, and the maximum number
+// of arguments in it.
+#define MAX_BATCH_LINE 4096
+#define MAX_BATCH_ARGS 256
 ///
 
 /// Parse the subsampling factors off.
@@ -82,22 +92,26 @@ void ParseSubsamplingFactors(UBYTE *sx,UBYTE *sy,const char *sub,int cnt)
 ///
 
 /// ParseDouble
-// Parse off a floating point value, or print an error
-double ParseDouble(int &argc,char **&argv)
+// Parse off a floating point value, or print an error and
+// clear the ok flag.
+double ParseDouble(int &argc,char **&argv,bool &ok)
 {
   double v;
   char *endptr;
   
   if (argv[2] == NULL) {
     fprintf(stderr,"%s expected a numeric argument.\n",argv[1]);
-    exit(25);
+    ok = false;
+    argc--;
+    argv++;
+    return 0.0;
   }
 
   v = strtod(argv[2],&endptr);
 
   if (*endptr) {
     fprintf(stderr,"%s expected a numeric argument, not %s.\n",argv[1],argv[2]);
-    exit(25);
+    ok = false;
   }
 
   argc -= 2;
@@ -108,22 +122,26 @@ double ParseDouble(int &argc,char **&argv)
 ///
 
 /// ParseInt
-// Parse off an integer, return it, or print an error.
-int ParseInt(int &argc,char **&argv)
+// Parse off an integer, return it, or print an error and
+// clear the ok flag.
+int ParseInt(int &argc,char **&argv,bool &ok)
 {
   long int v;
   char *endptr;
   
   if (argv[2] == NULL) {
     fprintf(stderr,"%s expected a numeric argument.\n",argv[1]);
-    exit(25);
+    ok = false;
+    argc--;
+    argv++;
+    return 0;
   }
 
   v = strtol(argv[2],&endptr,0);
 
   if (*endptr) {
     fprintf(stderr,"%s expected a numeric argument, not %s.\n",argv[1],argv[2]);
-    exit(25);
+    ok = false;
   }
 
   argc -= 2;
@@ -134,14 +152,18 @@ int ParseInt(int &argc,char **&argv)
 ///
 
 /// ParseString
-// Parse of a string argument, return it, or print an error
-const char *ParseString(int &argc,char **&argv)
+// Parse of a string argument, return it, or print an error and
+// clear the ok flag.
+const char *ParseString(int &argc,char **&argv,bool &ok)
 {
   const char *v;
   
   if (argv[2] == NULL) {
     fprintf(stderr,"%s expects a string argument.\n",argv[1]);
-    exit(25);
+    ok = false;
+    argc--;
+    argv++;
+    return "";
   }
 
   v = argv[2];
@@ -174,7 +196,11 @@ void PrintLicense(void)
 void PrintUsage(const char *progname)
 {    
   printf("Usage: %s [options] source target\n"
+          "   or: %s -batch manifest\n"
           "default is to decode the jpeg input and write a ppm output\n"
+          "-batch runs one job per line of the manifest, or of stdin if the\n"
+          "manifest is -. Each line lists options, source and target as on\n"
+          "the command line, lines starting with # are ignored.\n\n"
           "use -q [1..100] or -p to enforce encoding\n\n"
           "-q quality : selects the encoding mode and defines the quality of the base image\n"
           "-Q quality : defines the quality for the extension layer\n"
@@ -237,6 +263,8 @@ void PrintUsage(const char *progname)
           "             the DCT residuals of the first scan. For that, -c is suggested\n"
           "             for true lossless. If levels is one, then the lossy initial scan\n"
           "             is downscaled by a power of two.\n"
+          "-yl levels : on decoding a hierarchical JPEG, only decode the given number of\n"
+          "             resolution levels and write the image at this resolution.\n"
 #endif
           "-g gamma   : define the exponent for the gamma for the LDR domain, or rather, for\n"
           "             mapping HDR to LDR. A suggested value is 2.4 for mapping scRGB to sRBG.\n"
@@ -250,6 +278,12 @@ void PrintUsage(const char *progname)
           "             in total, where h is the number of refinement bits. Each line contains\n"
           "             an (integer) output value the corresponding input is mapped to.\n"
           "-z mcus    : define the restart interval size, zero disables it\n"
+          "-ds        : on decoding, reconstruct the image while it is decoded and release\n"
+          "             coefficients as soon as possible to limit the memory footprint\n"
+          "             on encoding, write the codestream while the image is read\n"
+          "-tr        : losslessly transcode the JPEG source into a JPEG target by\n"
+          "             re-encoding its DCT coefficients, the target frame type is\n"
+          "             selected by -v, -h, -a and -z\n"
 #if ACCUSOFT_CODE
           "-n         : indicate the image height by a DNL marker\n"
 #endif
@@ -263,6 +297,8 @@ void PrintUsage(const char *progname)
           "-rv        : encode the residual image in progressive coding mode\n"
           "-ol        : open loop encoding, residuals are based on original, not reconstructed\n"
           "-dz        : improved deadzone quantizer, may help to improve the R/D performance\n"
+          "-rdo n     : rate-distortion optimized quantization of strength n, e.g. 8,\n"
+          "             8-bit Huffman coding only\n"
           "-qt n      : define the quantization table. The following tables are currently defined:\n"
           "             n = 0 the default tables from Annex K of the JPEG standard (default)\n"
           "             n = 1 a completely flat table that should be PSNR-optimal\n"
@@ -315,17 +351,22 @@ void PrintUsage(const char *progname)
           "             AND NOT CONFORMING TO 10918-1. Works for near-lossless JPEG LS\n"
           "             DO NOT USE FOR LOSSY 10918-1, it will also create artifacts.\n"
 #endif
-          ,progname);
+          ,progname,progname);
 }
 ///
 
-/// main
-int main(int argc,char **argv)
+/// RunJob
+// Run a single encoding or decoding job as defined by the command line
+// arguments, return the exit code of the program.
+static int RunJob(int argc,char **argv)
 {
   int quality       = -1;
   int hdrquality    = -1;
   int maxerror      = 0;
   int levels        = 0;
+  int declevels     = 0;  // resolution levels to decode, zero for all.
+  bool stream       = false; // reconstruct while decoding
+  bool transcode    = false; // re-encode the coefficients of a JPEG input
   int restart       = 0;
   int lsmode        = -1; // Use JPEGLS
   int hiddenbits    = 0;  // hidden DCT bits
@@ -355,6 +396,7 @@ int main(int argc,char **argv)
   bool dctbypass    = false;
   bool openloop     = false;
   bool deadzone     = false;
+  int  rdo          = 0;
   bool aopenloop    = false;
   bool adeadzone    = false;
   bool xyz          = false;
@@ -381,19 +423,17 @@ int main(int argc,char **argv)
   int alphatt           = 0;
   int residualalphatt   = 0;
   int smooth            = 0; // histogram smoothing
+  bool ok               = true; // cleared on invalid arguments
 
-  PrintLicense();
-  fflush(stdout);
-
-  while(argc > 3 && argv[1][0] == '-') {
+  while(ok && argc > 3 && argv[1][0] == '-') {
     if (!strcmp(argv[1],"-q")) {
-      quality = ParseInt(argc,argv);
+      quality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-Q")) {
-      hdrquality = ParseInt(argc,argv);
+      hdrquality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-quality")) {
-      splitquality = ParseInt(argc,argv);
+      splitquality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-profile")) {
-      const char *s = ParseString(argc,argv);
+      const char *s = ParseString(argc,argv,ok);
       setprofile    = true;
       if (!strcmp(s,"a") || !strcmp(s,"A")) {
         profile = 0;
@@ -409,7 +449,7 @@ int main(int argc,char **argv)
         return 20;
       }
     } else if (!strcmp(argv[1],"-m")) {
-      maxerror = ParseInt(argc,argv);
+      maxerror = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-md")) {
       median = true;
       argv++;
@@ -419,17 +459,17 @@ int main(int argc,char **argv)
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-sm")) {
-      smooth = ParseInt(argc,argv);
+      smooth = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-z")) {
-      restart = ParseInt(argc,argv);
+      restart = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-r")) {
       residuals = true;
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-R")) {
-      hiddenbits = ParseInt(argc,argv);
+      hiddenbits = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-rR")) {
-      riddenbits = ParseInt(argc,argv);
+      riddenbits = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-n")) {
       writednl   = true;
       argv++;
@@ -448,23 +488,23 @@ int main(int argc,char **argv)
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-s")) {
-      sub    = ParseString(argc,argv);
+      sub    = ParseString(argc,argv,ok);
     } else if (!strcmp(argv[1],"-sr")) {
-      ressub = ParseString(argc,argv);
+      ressub = ParseString(argc,argv,ok);
     } else if (!strcmp(argv[1],"-ncl")) {
       noclamp = true;
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-al")) {
-      alpha   = ParseString(argc,argv);
+      alpha   = ParseString(argc,argv,ok);
     } else if (!strcmp(argv[1],"-am")) {
-      alphamode = ParseInt(argc,argv);
+      alphamode = ParseInt(argc,argv,ok);
       if (alphamode < 0 || alphamode > 3) {
         fprintf(stderr,"the alpha mode specified with -am must be between 0 and 3\n");
         return 20;
       }
     } else if (!strcmp(argv[1],"-ab")) {
-      const char *matte = ParseString(argc,argv);
+      const char *matte = ParseString(argc,argv,ok);
       if (sscanf(matte,"%d,%d,%d",&matte_r,&matte_g,&matte_b) != 3) {
         fprintf(stderr,"-ab expects three numeric arguments separated comma, i.e. r,g,b\n");
         return 20;
@@ -550,14 +590,16 @@ int main(int argc,char **argv)
       deadzone = true;
       argv++;
       argc--;
+    } else if (!strcmp(argv[1],"-rdo")) {
+      rdo = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-qt")) {
-      tabletype = ParseInt(argc,argv);
+      tabletype = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-rqt")) {
-      residualtt = ParseInt(argc,argv);
+      residualtt = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-aqt")) {
-      alphatt = ParseInt(argc,argv);
+      alphatt = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-arqt")) {
-      residualalphatt = ParseInt(argc,argv);
+      residualalphatt = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-aol")) {
       aopenloop = true;
       argv++;
@@ -567,21 +609,21 @@ int main(int argc,char **argv)
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-ldr")) {
-      ldrsource = ParseString(argc,argv);
+      ldrsource = ParseString(argc,argv,ok);
     } else if (!strcmp(argv[1],"-l")) {
       serms = true;
       argv++;
       argc--;
     } else if (!strcmp(argv[1],"-g")) {
-      gamma = ParseDouble(argc,argv);
+      gamma = ParseDouble(argc,argv,ok);
     } else if (!strcmp(argv[1],"-gf")) {
-      lsource = ParseString(argc,argv);
+      lsource = ParseString(argc,argv,ok);
     } else if (!strcmp(argv[1],"-aq")) {
-      alphaquality = ParseInt(argc,argv);
+      alphaquality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-aQ")) {
-      alphahdrquality = ParseInt(argc,argv);
+      alphahdrquality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-aquality")) {
-      alphasplitquality = ParseInt(argc,argv);
+      alphasplitquality = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-ar")) {
       alpharesiduals = true;
       argv++;
@@ -591,14 +633,22 @@ int main(int argc,char **argv)
       aresprec = 12;
       argv++;
       argc--;
+    } else if (!strcmp(argv[1],"-ds")) {
+      stream = true;
+      argv++;
+      argc--;
+    } else if (!strcmp(argv[1],"-tr")) {
+      transcode = true;
+      argv++;
+      argc--;
     } else if (!strcmp(argv[1],"-aR")) {
-      ahiddenbits = ParseInt(argc,argv);
+      ahiddenbits = ParseInt(argc,argv,ok);
     } else if (!strcmp(argv[1],"-arR")) {
-      ariddenbits = ParseInt(argc,argv);
+      ariddenbits = ParseInt(argc,argv,ok);
     }
 #if ACCUSOFT_CODE
     else if (!strcmp(argv[1],"-y")) {
-      levels = ParseInt(argc,argv);
+      levels = ParseInt(argc,argv,ok);
       if (levels == 0 || levels == 1) {
         // In this mode, the hierarchical model is used for lossless coding
         levels++;
@@ -606,16 +656,21 @@ int main(int argc,char **argv)
       } else {
         pyramidal = true;
       }
-    } 
+    } else if (!strcmp(argv[1],"-yl")) {
+      declevels = ParseInt(argc,argv,ok);
+    }
 #endif
     else if (!strcmp(argv[1],"-ls")) {
-      lsmode = ParseInt(argc,argv);
+      lsmode = ParseInt(argc,argv,ok);
     } else {
       fprintf(stderr,"unsupported command line switch %s\n",argv[1]);
       return 20;
     }
   }
 
+  if (!ok)
+    return 25;
+
   //
   // Use a very simplistic quality split.
   if (splitquality > 0) {
@@ -642,7 +697,7 @@ int main(int argc,char **argv)
       fprintf(stderr,"Error in argument parsing, argument %s not understood or parsed correctly.\n"
               "Run without arguments for a list of command line options.\n\n",
               argv[1]);
-      exit(20);
+      return 20;
     }
 
     PrintUsage(argv[0]);
@@ -650,33 +705,34 @@ int main(int argc,char **argv)
     return 5;
   }
 
-  if (quality < 0 && lossless == false && lsmode < 0) {
-    Reconstruct(argv[1],argv[2],colortrafo,alpha);
+  if (transcode) {
+    return Transcode(argv[1],argv[2],progressive,optimize,accoding,restart);
+  } else if (quality < 0 && lossless == false && lsmode < 0) {
+    return Reconstruct(argv[1],argv[2],colortrafo,alpha,declevels,stream);
   } else {
     switch(profile) {
     case 0:
       fprintf(stderr,"**** Profile A encoding not supported due to patented IPRs.\n");
-      break;
+      return 20;
     case 1:
       fprintf(stderr,"**** Profile B encoding not supported due to patented IPRs.\n");
-      break;
+      return 20;
     case 2:
     case 4:
       if (setprofile && ((residuals == false && hiddenbits == false && profile != 4) || profile == 2))
         residuals = true;
-      EncodeC(argv[1],ldrsource,argv[2],lsource,quality,hdrquality,
-              tabletype,residualtt,maxerror,colortrafo,
-              lossless,progressive,
-              residuals,optimize,accoding,rsequential,rprogressive,raccoding,
-              dconly,levels,pyramidal,writednl,restart,
-              gamma,lsmode,noiseshaping,serms,losslessdct,dctbypass,openloop,deadzone,xyz,cxyz,
-              hiddenbits,riddenbits,resprec,separate,median,smooth,noclamp,
-              sub,ressub,
-              alpha,alphamode,matte_r,matte_g,matte_b,
-              alpharesiduals,alphaquality,alphahdrquality,
-              alphatt,residualalphatt,
-              ahiddenbits,ariddenbits,aresprec,aopenloop,adeadzone,aserms,abypass);
-      break;
+      return EncodeC(argv[1],ldrsource,argv[2],lsource,quality,hdrquality,
+                     tabletype,residualtt,maxerror,colortrafo,
+                     lossless,progressive,
+                     residuals,optimize,accoding,rsequential,rprogressive,raccoding,
+                     dconly,levels,pyramidal,writednl,restart,stream,
+                     gamma,lsmode,noiseshaping,serms,losslessdct,dctbypass,openloop,deadzone,rdo,xyz,cxyz,
+                     hiddenbits,riddenbits,resprec,separate,median,smooth,noclamp,
+                     sub,ressub,
+                     alpha,alphamode,matte_r,matte_g,matte_b,
+                     alpharesiduals,alphaquality,alphahdrquality,
+                     alphatt,residualalphatt,
+                     ahiddenbits,ariddenbits,aresprec,aopenloop,adeadzone,aserms,abypass);
     }
   }
   
@@ -684,3 +740,148 @@ int main(int argc,char **argv)
 }
 ///
 
+/// WallClock
+// Return a wall clock time in seconds for timing batch jobs.
+static double WallClock(void)
+{
+#if defined(HAVE_SYS_TIME_H) && defined(HAVE_GETTIMEOFDAY)
+  struct timeval tv;
+  
+  gettimeofday(&tv,NULL);
+  
+  return tv.tv_sec + tv.tv_usec * 1e-6;
+#else
+  return double(clock()) / CLOCKS_PER_SEC;
+#endif
+}
+///
+
+/// SplitJobLine
+// Split a line of a batch manifest into arguments, in place. Arguments
+// are separated by white space, double quotes group white space into an
+// argument. The first argument is the program name. Returns the number
+// of arguments, or -1 if the line has too many of them.
+static int SplitJobLine(char *line,char *progname,char **argv)
+{
+  int argc = 0;
+
+  argv[argc++] = progname;
+  
+  for(;;) {
+    char *out;
+    bool quoted = false;
+    
+    while(*line == ' ' || *line == '\t' || *line == '\r' || *line == '\n')
+      line++;
+    if (*line == 0)
+      break;
+    if (argc >= MAX_BATCH_ARGS)
+      return -1;
+    //
+    // Collect the argument, dropping the quotes.
+    argv[argc++] = out = line;
+    while(*line) {
+      if (*line == '"') {
+        quoted = !quoted;
+        line++;
+      } else if (!quoted && (*line == ' ' || *line == '\t' || *line == '\r' || *line == '\n')) {
+        line++;
+        break;
+      } else {
+        *out++ = *line++;
+      }
+    }
+    *out = 0;
+  }
+  argv[argc] = NULL;
+
+  return argc;
+}
+///
+
+/// RunBatch
+// Run the jobs listed in a manifest file, or in the lines read from
+// stdin, one after another in this process. This saves the process
+// startup for every job. A line reporting the exit code and the time
+// of each job is printed once the job is done, such that a driver
+// feeding commands through a pipe can wait for it.
+// Jobs are not distributed over worker threads and do not share JPEG
+// objects: a JPEG object cannot be reset for another image, and
+// constructing one costs next to nothing compared to coding an image.
+static int RunBatch(char *progname,const char *manifest)
+{
+  char line[MAX_BATCH_LINE];
+  char *argv[MAX_BATCH_ARGS + 1];
+  bool  usestdin = !strcmp(manifest,"-");
+  FILE *in       = (usestdin)?(stdin):(fopen(manifest,"r"));
+  ULONG jobs     = 0;
+  ULONG failed   = 0;
+  double start   = WallClock();
+
+  if (in == NULL) {
+    perror("failed to open the batch manifest");
+    return 20;
+  }
+
+  while(fgets(line,sizeof(line),in)) {
+    size_t len     = strlen(line);
+    bool truncated = len == sizeof(line) - 1 && line[len - 1] != '\n';
+    double t;
+    int argc,rc;
+    //
+    if (truncated) {
+      int c;
+      // The line is too long, skip the remainder.
+      while((c = fgetc(in)) != EOF && c != '\n') {
+      }
+    }
+    //
+    // Skip over comments and empty lines.
+    argc = SplitJobLine(line,progname,argv);
+    if (argc == 1 || (argc > 1 && argv[1][0] == '#'))
+      continue;
+    jobs++;
+    if (truncated) {
+      fprintf(stderr,"batch job %lu: the manifest line is too long\n",(unsigned long)jobs);
+      argc = -1;
+    } else if (argc < 0) {
+      fprintf(stderr,"batch job %lu: too many arguments\n",(unsigned long)jobs);
+    }
+    //
+    if (argc < 0) {
+      rc = 20;
+      t  = 0.0;
+    } else {
+      t  = WallClock();
+      rc = RunJob(argc,argv);
+      t  = WallClock() - t;
+    }
+    if (rc)
+      failed++;
+    printf("batch job %lu: exit code %d, %.3f seconds\n",(unsigned long)jobs,rc,t);
+    fflush(stdout);
+  }
+
+  if (!usestdin)
+    fclose(in);
+  
+  printf("batch done: %lu jobs, %lu failed, %.3f seconds\n",
+         (unsigned long)jobs,(unsigned long)failed,WallClock() - start);
+
+  return (failed)?(10):(0);
+}
+///
+
+/// main
+int main(int argc,char **argv)
+{
+  PrintLicense();
+  fflush(stdout);
+
+  if (argc == 3 && !strcmp(argv[1],"-batch"))
+    return RunBatch(argv[0],argv[2]);
+
+  return RunJob(argc,argv);
+}
+///
+
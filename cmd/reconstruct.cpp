@@ -48,10 +48,12 @@
 
 /// Reconstruct
 // This reconstructs an image from the given input file
-// and writes the output ppm.
-void Reconstruct(const char *infile,const char *outfile,
-                 int colortrafo,const char *alpha)
+// and writes the output ppm. Returns zero on success, or
+// the exit code of the program on failure.
+int Reconstruct(const char *infile,const char *outfile,
+                int colortrafo,const char *alpha,int levels,bool stream)
 {  
+  int rc   = 0;
   FILE *in = fopen(infile,"rb");
   if (in) {
     struct JPG_Hook filehook(FileHook,in);
@@ -62,10 +64,33 @@ void Reconstruct(const char *infile,const char *outfile,
         JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&filehook),
         JPG_PointerTag(JPGTAG_HOOK_IOSTREAM,in), 
         JPG_ValueTag(JPGTAG_MATRIX_LTRAFO,colortrafo),
+        JPG_ValueTag(JPGTAG_DECODER_RESOLUTION_LEVELS,levels),
+        // In streaming mode, only parse the frame header here, the
+        // rest is decoded once the output is set up.
+        JPG_ValueTag(JPGTAG_DECODER_STOP,(stream)?(JPGFLAG_DECODER_STOP_FRAME):(0)),
         JPG_EndTag
       };
 
-      if (jpeg->Read(tags)) {
+      ok = jpeg->Read(tags);
+      if (ok && stream) {
+        struct JPG_TagItem htags[] = {
+          JPG_ValueTag(JPGTAG_IMAGE_HEIGHT,0),
+          JPG_EndTag
+        };
+        struct JPG_TagItem rtags[] = {
+          JPG_ValueTag(JPGTAG_DECODER_STOP,0),
+          JPG_EndTag
+        };
+        //
+        // If the height is defined by a DNL marker, it is not yet known
+        // and the output cannot be set up. Decode the full image upfront.
+        if (jpeg->GetInformation(htags) && htags->GetTagData(JPGTAG_IMAGE_HEIGHT) == 0) {
+          stream = false;
+          ok     = jpeg->Read(rtags);
+        }
+      }
+
+      if (ok) {
         struct JPG_TagItem atags[] = {
           JPG_ValueTag(JPGTAG_IMAGE_PRECISION,0),
           JPG_ValueTag(JPGTAG_IMAGE_IS_FLOAT,false),
@@ -172,23 +197,37 @@ void Reconstruct(const char *infile,const char *outfile,
                         (apfm)?('f'):('5'),
                         width,height,(apfm)?(1):((1 << aprec) - 1));
 
-              //
-              // Reconstruct now the buffered image, line by line. Could also
-              // reconstruct the image as a whole. What we have here is just a demo
-              // that is not necessarily the most efficient way of handling images.
-              do {
-                lastline = height;
-                if (lastline > y + 8)
-                  lastline = y + 8;
-                tags[2].ti_Data.ti_lData = y;
-                tags[3].ti_Data.ti_lData = lastline - 1;
-                ok = jpeg->DisplayRectangle(tags);
-                y  = lastline;
-              } while(y < height && ok);
+              if (stream) {
+                struct JPG_TagItem stags[] = {
+                  JPG_PointerTag(JPGTAG_BIH_HOOK,&bmhook),
+                  JPG_PointerTag(JPGTAG_BIH_ALPHAHOOK,&alphahook),
+                  JPG_ValueTag(JPGTAG_DECODER_STREAM_RECONSTRUCTION,true),
+                  JPG_EndTag
+                };
+                //
+                // Decode the rest of the image, the library delivers the
+                // image through the bitmap hook in stripes of eight lines.
+                ok = jpeg->Read(stags);
+              } else {
+                //
+                // Reconstruct now the buffered image, line by line. Could also
+                // reconstruct the image as a whole. What we have here is just a demo
+                // that is not necessarily the most efficient way of handling images.
+                do {
+                  lastline = height;
+                  if (lastline > y + 8)
+                    lastline = y + 8;
+                  tags[2].ti_Data.ti_lData = y;
+                  tags[3].ti_Data.ti_lData = lastline - 1;
+                  ok = jpeg->DisplayRectangle(tags);
+                  y  = lastline;
+                } while(y < height && ok);
+              }
 
               fclose(bmm.bmm_pTarget);
             } else {
               perror("failed to open the output file");
+              rc = 20;
             }
 
             if (bmm.bmm_pAlphaTarget)
@@ -200,6 +239,7 @@ void Reconstruct(const char *infile,const char *outfile,
             free(mem);
           } else {
             fprintf(stderr,"unable to allocate memory to buffer the image");
+            rc = 20;
           }
         } else ok = 0;
       } else ok = 0;
@@ -208,14 +248,19 @@ void Reconstruct(const char *infile,const char *outfile,
         const char *error;
         int code = jpeg->LastError(error);
         fprintf(stderr,"reading a JPEG file failed - error %d - %s\n",code,error);
+        rc = 20;
       }
       JPEG::Destruct(jpeg);
     } else {
       fprintf(stderr,"failed to construct the JPEG object");
+      rc = 20;
     }
     fclose(in);
   } else {
     perror("failed to open the input file");
+    rc = 20;
   }
+
+  return rc;
 }
 ///
@@ -36,7 +36,8 @@
 #define CMD_RECONSTRUCT_HPP
 
 /// Prototypes
-extern void Reconstruct(const char *infile,const char *outfile,int colortrafo,const char *alpha);
+extern int Reconstruct(const char *infile,const char *outfile,int colortrafo,const char *alpha,
+                       int levels,bool stream);
 ///
 
 ///
@@ -0,0 +1,107 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This file defines the scan tag lists of the standard progressive
+** scan script shared by the command line front-ends and the benchmark.
+**
+*/
+
+/// Includes
+#include "cmd/scans.hpp"
+#include "interface/types.hpp"
+#include "interface/parameters.hpp"
+///
+
+/// ProgressiveScan1
+// Standard progressive scan, first scan: DC of all components.
+struct JPG_TagItem ProgressiveScan1[] = {
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,0),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan2
+struct JPG_TagItem ProgressiveScan2[] = {
+  JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,5),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,2),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan3
+struct JPG_TagItem ProgressiveScan3[] = {
+  JPG_ValueTag(JPGTAG_SCAN_COMPONENTS_CHROMA,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan4
+struct JPG_TagItem ProgressiveScan4[] = {
+  JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,6),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,2),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan5
+struct JPG_TagItem ProgressiveScan5[] = {
+  JPG_ValueTag(JPGTAG_SCAN_COMPONENT0,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,1),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,2),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan6
+struct JPG_TagItem ProgressiveScan6[] = {
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,0),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,0),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,0),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,1),
+  JPG_EndTag
+};
+///
+
+/// ProgressiveScan7
+struct JPG_TagItem ProgressiveScan7[] = {
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_START,1),
+  JPG_ValueTag(JPGTAG_SCAN_SPECTRUM_STOP,63),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_LO,0),
+  JPG_ValueTag(JPGTAG_SCAN_APPROXIMATION_HI,1),
+  JPG_EndTag
+};
+///
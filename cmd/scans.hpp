@@ -0,0 +1,53 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This file defines the scan tag lists of the standard progressive
+** scan script shared by the command line front-ends and the benchmark.
+**
+*/
+
+#ifndef CMD_SCANS_HPP
+#define CMD_SCANS_HPP
+
+/// Includes
+#include "interface/tagitem.hpp"
+///
+
+/// Progressive scan script
+// The seven scans of the standard progressive mode, to be installed
+// in this order as JPGTAG_IMAGE_SCAN tags: spectral selection of the
+// DC and AC bands first, followed by the refinement scans.
+extern struct JPG_TagItem ProgressiveScan1[];
+extern struct JPG_TagItem ProgressiveScan2[];
+extern struct JPG_TagItem ProgressiveScan3[];
+extern struct JPG_TagItem ProgressiveScan4[];
+extern struct JPG_TagItem ProgressiveScan5[];
+extern struct JPG_TagItem ProgressiveScan6[];
+extern struct JPG_TagItem ProgressiveScan7[];
+///
+
+///
+#endif
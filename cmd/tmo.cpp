@@ -180,12 +180,86 @@ static void save_histogram(const char *filename,double hist[256])
 #endif
 ///
 
+/// struct LDRBucket
+// The histogram of the HDR values that map to a single LDR value, along with
+// some statistics that are collected while the histogram is built. These
+// limit the table construction to the populated part of the histogram.
+struct LDRBucket {
+  // The histogram itself, indexed by the HDR value.
+  int  *hist;
+  // Number of samples in the histogram.
+  int   count;
+  // Minimum and maximum HDR value with a nonzero histogram count.
+  int   min;
+  int   max;
+  // Sum of all HDR values in the histogram.
+  UQUAD sum;
+};
+///
+
+/// AllocBuckets
+// Allocate and initialize the given number of histogram buckets for hdrcnt
+// HDR values each. Returns NULL if running out of memory. The histograms
+// are allocated zero-initialized such that unpopulated parts never
+// need to be touched.
+static struct LDRBucket *AllocBuckets(int count,int hdrcnt)
+{
+  struct LDRBucket *buckets = (struct LDRBucket *)malloc(sizeof(struct LDRBucket) * count);
+  int i;
+
+  if (buckets) {
+    for(i = 0;i < count;i++) {
+      buckets[i].hist  = (int *)calloc(hdrcnt,sizeof(int));
+      buckets[i].count = 0;
+      buckets[i].min   = hdrcnt;
+      buckets[i].max   = -1;
+      buckets[i].sum   = 0;
+      if (buckets[i].hist == NULL) {
+        while(i > 0) {
+          free(buckets[--i].hist);
+        }
+        free(buckets);
+        return NULL;
+      }
+    }
+  }
+  return buckets;
+}
+///
+
+/// FreeBuckets
+// Release the histogram buckets again.
+static void FreeBuckets(struct LDRBucket *buckets,int count)
+{
+  int i;
+
+  for(i = 0;i < count;i++) {
+    free(buckets[i].hist);
+  }
+  free(buckets);
+}
+///
+
+/// AddToBucket
+// Enter a sample with the given HDR value into the bucket of its LDR value.
+static inline void AddToBucket(struct LDRBucket *bucket,int hdr)
+{
+  bucket->hist[hdr]++;
+  bucket->count++;
+  bucket->sum += hdr;
+  if (hdr < bucket->min)
+    bucket->min = hdr;
+  if (hdr > bucket->max)
+    bucket->max = hdr;
+}
+///
+
 /// BuildIntermediateTable
 // Build an intermediate table from a histogram.
-void BuildIntermediateTable(int **hists,int offs,int hdrcnt,
-                            UWORD ldrtohdr[65536],int hiddenbits,
-                            bool median,bool &fullrange,bool flt,
-                            int smooth)
+static void BuildIntermediateTable(const struct LDRBucket *buckets,int hdrcnt,
+                                   UWORD ldrtohdr[65536],int hiddenbits,
+                                   bool median,bool &fullrange,bool flt,
+                                   int smooth)
 {     
   int i,j,k;
   double intermed[256];
@@ -197,16 +271,10 @@ void BuildIntermediateTable(int **hists,int offs,int hdrcnt,
   // Several methods could be used here.
   // As a starter, use the average.
   for(i = 0;i < 256;i++) {
-    int count  = 0;
-    int min    = -1;
-    int max    = -1;
-    for(j = 0;j < hdrcnt;j++) {
-      count += hists[i+offs][j];
-      if (hists[i+offs][j] > 0) {
-        if (min == -1) min = j;
-        max = j;
-      }
-    }
+    const struct LDRBucket *bucket = buckets + i;
+    int count  = bucket->count;
+    int min    = bucket->min;
+    int max    = bucket->max;
     if (count > 0) {
       if (max > absmax)
         absmax = max;
@@ -217,21 +285,22 @@ void BuildIntermediateTable(int **hists,int offs,int hdrcnt,
         intermed[i] = (max - min) >> 1;
       } else {
         if (median) {
+          // The histogram is empty outside of [min,max], so the
+          // scan can start at min unless half the count is zero.
           int median = 0;
-          for(j = 0;j < hdrcnt;j++) {
-            median += hists[i+offs][j];
-            if (median >= (count >> 1))
-              break;
+          if (count >> 1) {
+            for(j = min;j < max;j++) {
+              median += bucket->hist[j];
+              if (median >= (count >> 1))
+                break;
+            }
+          } else {
+            j = 0;
           }
           intermed[i] = j;
         } else {
-          double total = 0.0;
-          double sum   = 0.0;
-          for(j = 0;j < hdrcnt;j++) {
-            sum   += double(hists[i+offs][j]) * j;
-            total += double(hists[i+offs][j]);
-          }
-          intermed[i] = sum / total;
+          // The sum is exact, hence this is the center of mass.
+          intermed[i] = double(bucket->sum) / double(count);
         }
       }
     } else {
@@ -365,8 +434,9 @@ void BuildIntermediateTable(int **hists,int offs,int hdrcnt,
 
 /// BuildToneMappingFromLDR (for FLOAT)
 // Build an inverse tone mapping from a hdr/ldr image pair, though generate it as
-// a floating point table. This requires floating point input.
-void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
+// a floating point table. This requires floating point input. Returns false if
+// the images could not be read.
+bool BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
                              FLOAT ldrtohdr[256],
                              bool bigendian,bool median,bool fullrange,
                              int smooth)
@@ -376,7 +446,8 @@ void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
   DOUBLE scale;
   //
   // Call the generic function. This returns half-float values we still have to cast to float.
-  BuildToneMappingFromLDR(in,ldrin,w,h,16,count,tmp,true,bigendian,false,0,median,fullrange,smooth);
+  if (!BuildToneMappingFromLDR(in,ldrin,w,h,16,count,tmp,true,bigendian,false,0,median,fullrange,smooth))
+    return false;
   //
   // Potentially scale the map so we avoid clamping. This is necessary because the output
   // of this map goes into the 2nd base trafo, which implies input clamping. Profile A can
@@ -389,152 +460,161 @@ void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
   for(i = 0;i < 256;i++) {
     ldrtohdr[i] = HalfToDouble(tmp[i]) * scale; // This is the output transformation.
   }
+
+  return true;
 }
 ///
 
 /// BuildToneMappingFromLDR
-// Build an inverse tone mapping from a hdr/ldr image pair
-void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
+// Build an inverse tone mapping from a hdr/ldr image pair. Returns false
+// if the images could not be read.
+bool BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
                              UWORD ldrtohdr[65536],bool flt,
                              bool bigendian,bool xyz,int hiddenbits,bool median,bool &fullrange,
                              int smooth)
 {
   long hpos  = ftell(in);
   long lpos  = ftell(ldrin);
-  int **hists = NULL; // Histograms for each LDR pixel value.
-  int i;
+  struct LDRBucket *buckets = NULL; // Histograms for each LDR pixel value.
   int hdrcnt = (flt)?(65536):(1 << depth);
   int x,y;
-  bool warn = false;
+  bool warn   = false;
+  bool failed = false;
+  // The rows of both images, read in one go each.
+  UBYTE *hrow = (UBYTE *)malloc(PNMRowSize(w,depth,count,flt));
+  UBYTE *lrow = (UBYTE *)malloc(PNMRowSize(w,8,count,false));
 
-  hists     = (int **)malloc(sizeof(int *) * 256);
+  buckets   = (hrow && lrow)?(AllocBuckets(256,hdrcnt)):(NULL);
   fullrange = false;
-  if (hists) {
-    memset(hists,0,sizeof(int *) * 256);
-    for(i = 0;i < 256;i++) {
-      hists[i] = (int *)malloc(sizeof(int) * hdrcnt);
-      if (hists[i] == NULL)
+  if (buckets) {
+    for(y = 0;y < h && !failed;y++) {
+      if (!ReadPNMRow(in   ,hrow,w,depth,count,flt  ,bigendian) ||
+          !ReadPNMRow(ldrin,lrow,w,8    ,count,false,false)) {
+        failed = true;
         break;
-      memset(hists[i],0,sizeof(int) * hdrcnt);
-    }
-    if (i == 256) {
-      for(y = 0;y < h;y++) {
-        for(x = 0;x < w;x++) {
-          // Read the HDR image parameters.
-          int r,g,b;
-          int rl,gl,bl;
-          double y;
-          //
-          warn |= ReadRGBTriple(in,r,g,b,y,depth,count,flt,bigendian,xyz);
-          /*
-          r     = y * (hdrcnt - 1) + 0.5;
-          if (r < 0)       r = 0;
-          if (r >= hdrcnt) r = hdrcnt - 1;
-          */
-          //
-          // Read the LDR parameters.
-          ReadRGBTriple(ldrin,rl,gl,bl,y,8,count,false,false,false);
-          /*
-          rl    = y * 255 + 0.5;
-          if (rl < 0)   rl = 0;
-          if (rl > 255) rl = 255;
-          */
-          // Update the histogram.
-          // Actually, here it might make sense to collect
-          // three histograms, not one. The coding core
-          // would actually even support this, though this
-          // frontend is currently limited.
-          hists[rl][r]++;
-          hists[gl][g]++;
-          hists[bl][b]++;
-        }
       }
-      //
-      // Build tables for each component.
-      BuildIntermediateTable(hists,0,hdrcnt,ldrtohdr,hiddenbits,median,fullrange,flt,smooth);
-      //
-      // Release the temporary storage for the histogram.
-      for(i = 0;i < 256;i++) {
-        free(hists[i]);
+      for(x = 0;x < w && !failed;x++) {
+        // Read the HDR image parameters.
+        int r,g,b;
+        int rl,gl,bl;
+        double y;
+        //
+        warn |= ConvertRGBTriple(hrow,x,r,g,b,y,depth,count,flt,xyz,failed);
+        /*
+        r     = y * (hdrcnt - 1) + 0.5;
+        if (r < 0)       r = 0;
+        if (r >= hdrcnt) r = hdrcnt - 1;
+        */
+        //
+        // Read the LDR parameters.
+        ConvertRGBTriple(lrow,x,rl,gl,bl,y,8,count,false,false,failed);
+        /*
+        rl    = y * 255 + 0.5;
+        if (rl < 0)   rl = 0;
+        if (rl > 255) rl = 255;
+        */
+        // Update the histogram.
+        // Actually, here it might make sense to collect
+        // three histograms, not one. The coding core
+        // would actually even support this, though this
+        // frontend is currently limited.
+        AddToBucket(buckets + rl,r);
+        AddToBucket(buckets + gl,g);
+        AddToBucket(buckets + bl,b);
       }
     }
-    free(hists);
+    //
+    // Build tables for each component.
+    if (!failed)
+      BuildIntermediateTable(buckets,hdrcnt,ldrtohdr,hiddenbits,median,fullrange,flt,smooth);
+    //
+    // Release the temporary storage for the histogram.
+    FreeBuckets(buckets,256);
   }
 
+  free(hrow);
+  free(lrow);
+
   fseek(in   ,hpos,SEEK_SET);
   fseek(ldrin,lpos,SEEK_SET);
 
   if (warn)
     fprintf(stderr,"Warning: Input image contains out of gamut values, clamping it.\n");
+
+  return !failed;
 }
 ///
 
 /// BuildRGBToneMappingFromLDR
-// Build an inverse tone mapping from a hdr/ldr image pair
-void BuildRGBToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
+// Build an inverse tone mapping from a hdr/ldr image pair. Returns false
+// if the images could not be read.
+bool BuildRGBToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
                                 UWORD red[65536],UWORD green[65536],UWORD blue[65536],
                                 bool flt,bool bigendian,bool xyz,int hiddenbits,
                                 bool median,bool &fullrange,int smooth)
 {
   long hpos  = ftell(in);
   long lpos  = ftell(ldrin);
-  int **hists = NULL; // Histograms for each LDR pixel value.
-  int i;
+  struct LDRBucket *buckets = NULL; // Histograms for each LDR pixel value.
   int hdrcnt = (flt)?(65536):(1 << depth);
   int x,y;
-  bool warn = false;
+  bool warn   = false;
+  bool failed = false;
+  // The rows of both images, read in one go each.
+  UBYTE *hrow = (UBYTE *)malloc(PNMRowSize(w,depth,count,flt));
+  UBYTE *lrow = (UBYTE *)malloc(PNMRowSize(w,8,count,false));
 
   fullrange = false;
-  hists     = (int **)malloc(sizeof(int *) * 256 * 3);
-  if (hists) {
-    memset(hists,0,sizeof(int *) * 256 * 3);
-    for(i = 0;i < 256 * 3;i++) {
-      hists[i] = (int *)malloc(sizeof(int) * hdrcnt);
-      if (hists[i] == NULL)
+  buckets   = (hrow && lrow)?(AllocBuckets(256 * 3,hdrcnt)):(NULL);
+  if (buckets) {
+    for(y = 0;y < h && !failed;y++) {
+      if (!ReadPNMRow(in   ,hrow,w,depth,count,flt  ,bigendian) ||
+          !ReadPNMRow(ldrin,lrow,w,8    ,count,false,false)) {
+        failed = true;
         break;
-      memset(hists[i],0,sizeof(int) * hdrcnt);
-    }
-    if (i == 256 * 3) {
-      for(y = 0;y < h;y++) {
-        for(x = 0;x < w;x++) {
-          // Read the HDR image parameters.
-          int r,g,b;
-          int rl,gl,bl;
-          double y;
-          //
-          warn |= ReadRGBTriple(in,r,g,b,y,depth,count,flt,bigendian,xyz);
-          //
-          // Read the LDR parameters.
-          ReadRGBTriple(ldrin,rl,gl,bl,y,8,count,false,false,false);
-          // Update the histogram.
-          // Actually, here it might make sense to collect
-          // three histograms, not one. The coding core
-          // would actually even support this, though this
-          // frontend is currently limited.
-          hists[rl + (0<<0)][r]++;
-          hists[gl + (1<<8)][g]++;
-          hists[bl + (2<<8)][b]++;
-        }
       }
-      //
-      // Build tables for each component.
-      BuildIntermediateTable(hists,0 << 8,hdrcnt,red  ,hiddenbits,median,fullrange,flt,smooth);
-      BuildIntermediateTable(hists,1 << 8,hdrcnt,green,hiddenbits,median,fullrange,flt,smooth);
-      BuildIntermediateTable(hists,2 << 8,hdrcnt,blue ,hiddenbits,median,fullrange,flt,smooth);
-      //
-      // Release the temporary storage for the histogram.
-      for(i = 0;i < 256;i++) {
-        free(hists[i]);
+      for(x = 0;x < w && !failed;x++) {
+        // Read the HDR image parameters.
+        int r,g,b;
+        int rl,gl,bl;
+        double y;
+        //
+        warn |= ConvertRGBTriple(hrow,x,r,g,b,y,depth,count,flt,xyz,failed);
+        //
+        // Read the LDR parameters.
+        ConvertRGBTriple(lrow,x,rl,gl,bl,y,8,count,false,false,failed);
+        // Update the histogram.
+        // Actually, here it might make sense to collect
+        // three histograms, not one. The coding core
+        // would actually even support this, though this
+        // frontend is currently limited.
+        AddToBucket(buckets + rl + (0<<0),r);
+        AddToBucket(buckets + gl + (1<<8),g);
+        AddToBucket(buckets + bl + (2<<8),b);
       }
     }
-    free(hists);
+    //
+    // Build tables for each component.
+    if (!failed) {
+      BuildIntermediateTable(buckets + (0 << 8),hdrcnt,red  ,hiddenbits,median,fullrange,flt,smooth);
+      BuildIntermediateTable(buckets + (1 << 8),hdrcnt,green,hiddenbits,median,fullrange,flt,smooth);
+      BuildIntermediateTable(buckets + (2 << 8),hdrcnt,blue ,hiddenbits,median,fullrange,flt,smooth);
+    }
+    //
+    // Release the temporary storage for the histogram.
+    FreeBuckets(buckets,256 * 3);
   }
 
+  free(hrow);
+  free(lrow);
+
   fseek(in   ,hpos,SEEK_SET);
   fseek(ldrin,lpos,SEEK_SET);
 
   if (warn)
     fprintf(stderr,"Warning: Input image contains out of gamut values, clamping it.\n");
+
+  return !failed;
 }
 ///
 
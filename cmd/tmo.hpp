@@ -46,20 +46,22 @@
 // invert numerically the (parametric) table.
 extern void InvertTable(UWORD input[65536],UWORD output[65536],UBYTE inbits,UBYTE outbits);
 //
-// Build an inverse tone mapping from a hdr/ldr image pair
-extern void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
+// Build an inverse tone mapping from a hdr/ldr image pair. Returns false
+// if the images could not be read.
+extern bool BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
                                     UWORD ldrtohdr[65536],bool flt,bool bigendian,bool xyz,
                                     int hiddenbits,bool median,bool &fullrange,
                                     int smooth);
 // Build an inverse tone mapping from a hdr/ldr image pair, though generate it as
 // a floating point table. This requires floating point input.
-extern void BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
+extern bool BuildToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int count,
                                     FLOAT ldrtohdr[256],
                                     bool bigendian,bool median,bool fullrange,
                                     int smooth);
 //
-// Build three inverse TMOs from a hdr/ldr image pair.
-extern void BuildRGBToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
+// Build three inverse TMOs from a hdr/ldr image pair. Returns false
+// if the images could not be read.
+extern bool BuildRGBToneMappingFromLDR(FILE *in,FILE *ldrin,int w,int h,int depth,int count,
                                        UWORD red[65536],UWORD green[65536],UWORD blue[65536],
                                        bool flt,bool bigendian,bool xyz,
                                        int hiddenbits,bool median,bool &fullrange,
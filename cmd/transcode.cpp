@@ -0,0 +1,134 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This file includes the transcoder front-end of the
+** command line interface. It decodes a JPEG file into
+** quantized coefficients and re-encodes them with a
+** different frame type, without touching the image data.
+**
+*/
+
+/// Includes
+#include "std/stdio.hpp"
+#include "cmd/transcode.hpp"
+#include "cmd/filehook.hpp"
+#include "cmd/scans.hpp"
+#include "tools/environment.hpp"
+#include "tools/traits.hpp"
+#include "interface/types.hpp"
+#include "interface/hooks.hpp"
+#include "interface/tagitem.hpp"
+#include "interface/parameters.hpp"
+#include "interface/jpeg.hpp"
+///
+
+/// Transcode
+// Read the given input file, and write its coefficients losslessly
+// into the output file using the frame type selected by the flags.
+// Returns zero on success, or the exit code of the program on failure.
+int Transcode(const char *infile,const char *outfile,
+              bool progressive,bool optimize,bool accoding,UWORD restart)
+{
+  int rc = 0;
+  FILE *in = fopen(infile,"rb");
+  if (in) {
+    struct JPG_Hook inhook(FileHook,in);
+    class JPEG *source = JPEG::Construct(NULL);
+    if (source) {
+      struct JPG_TagItem tags[] = {
+        JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&inhook),
+        JPG_PointerTag(JPGTAG_HOOK_IOSTREAM,in), 
+        JPG_EndTag
+      };
+      
+      if (source->Read(tags)) {
+        FILE *out = fopen(outfile,"wb");
+        if (out) {
+          class JPEG *target = JPEG::Construct(NULL);
+          if (target) {
+            int frametype = (progressive)?(JPGFLAG_PROGRESSIVE):(JPGFLAG_SEQUENTIAL);
+            int ok;
+            struct JPG_Hook outhook(FileHook,out);
+            struct JPG_TagItem ttags[] = {
+              JPG_ValueTag(JPGTAG_IMAGE_FRAMETYPE,frametype | 
+                           ((optimize)?(JPGFLAG_OPTIMIZE_HUFFMAN):(0)) |
+                           ((accoding)?(JPGFLAG_ARITHMETIC):(0))),
+              JPG_ValueTag(JPGTAG_IMAGE_RESTART_INTERVAL,restart),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan1),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan2),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan3),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan4),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan5),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan6),
+              JPG_PointerTag((progressive)?JPGTAG_IMAGE_SCAN:JPGTAG_TAG_IGNORE,ProgressiveScan7),
+              JPG_EndTag
+            };
+            struct JPG_TagItem iotags[] = {
+              JPG_PointerTag(JPGTAG_HOOK_IOHOOK,&outhook),
+              JPG_PointerTag(JPGTAG_HOOK_IOSTREAM,out),
+              JPG_EndTag
+            };
+            
+            ok = target->TranscodeImage(source,ttags);
+            if (ok)
+              ok = target->Write(iotags);
+            
+            if (!ok) {
+              const char *error;
+              int code = target->LastError(error);
+              fprintf(stderr,"transcoding a JPEG file failed - error %d - %s\n",code,error);
+              rc = 20;
+            }
+            JPEG::Destruct(target);
+          } else {
+            fprintf(stderr,"failed to construct the JPEG object");
+            rc = 20;
+          }
+          fclose(out);
+        } else {
+          perror("failed to open the output file");
+          rc = 20;
+        }
+      } else {
+        const char *error;
+        int code = source->LastError(error);
+        fprintf(stderr,"reading a JPEG file failed - error %d - %s\n",code,error);
+        rc = 20;
+      }
+      JPEG::Destruct(source);
+    } else {
+      fprintf(stderr,"failed to construct the JPEG object");
+      rc = 20;
+    }
+    fclose(in);
+  } else {
+    perror("failed to open the input file");
+    rc = 20;
+  }
+
+  return rc;
+}
+///
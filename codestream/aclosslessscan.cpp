@@ -57,8 +57,8 @@ ACLosslessScan::ACLosslessScan(class Frame *frame,class Scan *scan,UBYTE predict
   m_ucCount = scan->ComponentsInScan();
   
   for(int i = 0;i < m_ucCount;i++) {
-    m_ucSmall[i]     = 0;
-    m_ucLarge[i]     = 1;
+    m_lSmall[i]      = 0;
+    m_lLarge[i]      = 2;
   }
 
   memset(m_plDa,0,sizeof(m_plDa));
@@ -130,11 +130,11 @@ void ACLosslessScan::StartParseScan(class ByteStream *io,class Checksum *chk,cla
   for(i = 0;i < m_ucCount;i++) {
     dc = m_pScan->DCConditionerOf(i);
     if (dc) {
-      m_ucSmall[i]    = dc->LowerThresholdOf();
-      m_ucLarge[i]    = dc->UpperThresholdOf();
+      m_lSmall[i]     = (1L << dc->LowerThresholdOf()) >> 1;
+      m_lLarge[i]     = 1L << dc->UpperThresholdOf();
     } else {
-      m_ucSmall[i]    = 0;
-      m_ucLarge[i]    = 1;
+      m_lSmall[i]     = 0; // L = 0
+      m_lLarge[i]     = 2; // U = 1
     }
     memset(m_plDa[i],0,sizeof(LONG) * m_ucMCUHeight[i]); 
     memset(m_plDb[i],0,sizeof(LONG) * m_ulWidth[i]);
@@ -171,11 +171,11 @@ void ACLosslessScan::StartWriteScan(class ByteStream *io,class Checksum *chk,cla
     dc = m_pScan->DCConditionerOf(i);
 
     if (dc) {
-      m_ucSmall[i]    = dc->LowerThresholdOf();
-      m_ucLarge[i]    = dc->UpperThresholdOf();
+      m_lSmall[i]     = (1L << dc->LowerThresholdOf()) >> 1;
+      m_lLarge[i]     = 1L << dc->UpperThresholdOf();
     } else {
-      m_ucSmall[i]    = 0;
-      m_ucLarge[i]    = 1;
+      m_lSmall[i]     = 0; // L = 0
+      m_lLarge[i]     = 2; // U = 1
     }  
     memset(m_plDa[i],0,sizeof(LONG) * m_ucMCUHeight[i]);
     memset(m_plDb[i],0,sizeof(LONG) * m_ulWidth[i]);
@@ -229,6 +229,10 @@ void ACLosslessScan::WriteMCU(struct Line **prev,struct Line **top)
     ULONG  x = m_ulX[c];
     LONG *lp = line->m_pData + x;
     LONG *pp = (pline)?(pline->m_pData + x):(NULL);
+    LONG *da = m_plDa[c];
+    LONG *db = m_plDb[c];
+    LONG small = m_lSmall[c];
+    LONG large = m_lLarge[c];
     //
     // Write MCUwidth * MCUheight coefficients starting at the line top.
     do {
@@ -240,8 +244,7 @@ void ACLosslessScan::WriteMCU(struct Line **prev,struct Line **top)
         LONG v = pred->EncodeSample(lp,pp);
         //
         // Get the sign coding context.
-        struct QMContextSet::ContextZeroSet &zset = contextset.ClassifySignZero(m_plDa[c][ym-1],m_plDb[c][x],
-                                                                                m_ucSmall[c],m_ucLarge[c]);
+        struct QMContextSet::ContextZeroSet &zset = contextset.ClassifySignZero(da[ym-1],db[x]);
         // 
         if (v) {
           LONG sz;
@@ -256,7 +259,7 @@ void ACLosslessScan::WriteMCU(struct Line **prev,struct Line **top)
           }
           //
           if (sz >= 1) {
-            struct QMContextSet::MagnitudeSet &mset = contextset.ClassifyMagnitude(m_plDb[c][x],m_ucLarge[c]);
+            struct QMContextSet::MagnitudeSet &mset = contextset.ClassifyMagnitude(db[x]);
             int  i = 0;
             LONG m = 2;
             //
@@ -280,11 +283,9 @@ void ACLosslessScan::WriteMCU(struct Line **prev,struct Line **top)
           m_Coder.Put(zset.S0,false);
         }
         //
-        // Update Da and Db.
-        // Is this a bug? 32768 does not exist, but -32768 does. 
-        // The reference streams use -32768, so let's stick to that.
-        m_plDb[c][x]    = v;
-        m_plDa[c][ym-1] = v;
+        // Update Da and Db, classified once here.
+        // A difference of 32768 wraps around to -32768 in the predictor, as in the reference streams.
+        db[x] = da[ym-1] = (v)?(QMContextSet::Classify(v,small,large)):(0);
         //
         // One pixel done. Proceed to the next in the MCU. Note that
         // the lines have been extended such that always a complete MCU is present.
@@ -319,6 +320,10 @@ void ACLosslessScan::ParseMCU(struct Line **prev,struct Line **top)
     class PredictorBase *mcupred = m_pPredict[c];
     LONG *lp = line->m_pData + x;
     LONG *pp = (pline)?(pline->m_pData + x):(NULL);
+    LONG *da = m_plDa[c];
+    LONG *db = m_plDb[c];
+    LONG small = m_lSmall[c];
+    LONG large = m_lLarge[c];
     //
     // Parse MCUwidth * MCUheight coefficients starting at the line top.
     do {
@@ -330,15 +335,14 @@ void ACLosslessScan::ParseMCU(struct Line **prev,struct Line **top)
         LONG v;
         //
         // Get the sign coding context.
-        struct QMContextSet::ContextZeroSet &zset = contextset.ClassifySignZero(m_plDa[c][ym-1],m_plDb[c][x],
-                                                                                m_ucSmall[c],m_ucLarge[c]);
+        struct QMContextSet::ContextZeroSet &zset = contextset.ClassifySignZero(da[ym-1],db[x]);
         //
         if (m_Coder.Get(zset.S0)) {
           LONG sz   = 0;
           bool sign = m_Coder.Get(zset.SS); // true for negative.
           //
           if (m_Coder.Get((sign)?(zset.SN):(zset.SP))) {
-            struct QMContextSet::MagnitudeSet &mset = contextset.ClassifyMagnitude(m_plDb[c][x],m_ucLarge[c]);
+            struct QMContextSet::MagnitudeSet &mset = contextset.ClassifyMagnitude(db[x]);
             int  i = 0;
             LONG m = 2;
             //
@@ -367,11 +371,9 @@ void ACLosslessScan::ParseMCU(struct Line **prev,struct Line **top)
         //
         // Use the prediction to fill in the sample.
         lp[0] = pred->DecodeSample(v,lp,pp);
-        // Update Da and Db.
-        // Is this a bug? 32768 does not exist, but -32768 does. The streams
-        // seem to use -32768 instead.
-        m_plDb[c][x]    = v;
-        m_plDa[c][ym-1] = v;
+        // Update Da and Db, classified once here.
+        // A difference of 32768 wraps around to -32768 in the predictor, as in the reference streams.
+        db[x] = da[ym-1] = (v)?(QMContextSet::Classify(v,small,large)):(0);
         //
         // One pixel done. Proceed to the next in the MCU. Note that
         // the lines have been extended such that always a complete MCU is present.
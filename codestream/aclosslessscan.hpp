@@ -61,17 +61,21 @@ class ACLosslessScan : public PredictiveScan {
   // The class used for pulling and pushing data.
   class LineBuffer          *m_pLineCtrl;
   //
-  // Small DC threshold value ('L' in the standard)
-  UBYTE                      m_ucSmall[4];
+  // Small DC threshold ('L' in the standard), as the magnitude
+  // up to which a difference counts as zero, i.e. (1 << L) >> 1.
+  LONG                       m_lSmall[4];
   //
-  // Large DC threshold value ('U' in the specs)
-  UBYTE                      m_ucLarge[4];
+  // Large DC threshold ('U' in the specs), as the magnitude up to
+  // which a difference counts as small, i.e. 1 << U.
+  LONG                       m_lLarge[4];
   //
   // The context index to use.
   UBYTE                      m_ucContext[4];
   //
   // Differentials from the above and left, used
-  // for prediction.
+  // for prediction. These are kept classified into
+  // the five categories -2..2 of the conditioning such
+  // that each difference is only classified once.
   LONG                      *m_plDa[4];
   LONG                      *m_plDb[4];
   //
@@ -119,33 +123,34 @@ class ACLosslessScan : public PredictiveScan {
       MagnitudeHigh.Init();
     }
     //
-    // Classify and return the sign/zero coding context to encode the difference in.
-    // Requires the differences in both directions.
-    struct ContextZeroSet &ClassifySignZero(LONG Da,LONG Db,UBYTE l,UBYTE u)
+    // Return the sign/zero coding context to encode the difference in.
+    // Requires the classified differences in both directions.
+    struct ContextZeroSet &ClassifySignZero(LONG Da,LONG Db)
     {
-      return SignZeroCoding[Classify(Da,l,u) + 2][Classify(Db,l,u) + 2];
+      return SignZeroCoding[Da + 2][Db + 2];
     }
     //
-    // Classify the Magnitude context 
-    struct MagnitudeSet &ClassifyMagnitude(LONG Db,UBYTE u)
+    // Return the Magnitude context from the classified difference above.
+    struct MagnitudeSet &ClassifyMagnitude(LONG Db)
     {
-      if (Db > (1 << u) || -Db > (1 << u)) {
+      if (Db > 1 || Db < -1) {
         return MagnitudeHigh;
       } else {
         return MagnitudeLow;
       }
     }
     //
-    // Classifier in one direction.
-    static int Classify(LONG diff,UBYTE l,UBYTE u)
+    // Classifier in one direction, takes the thresholds
+    // as magnitudes.
+    static LONG Classify(LONG diff,LONG small,LONG large)
     {
       LONG abs = (diff > 0)?(diff):(-diff);
   
-      if (abs <= ((1 << l) >> 1)) {
+      if (abs <= small) {
         // the zero cathegory.
         return 0;
       }
-      if (abs <= (1 << u)) {
+      if (abs <= large) {
         if (diff < 0) {
           return -1;
         } else {
@@ -83,6 +83,9 @@ class Image *Decoder::ParseHeader(class ByteStream *io)
 // Accept decoder options.
 void Decoder::ParseTags(const struct JPG_TagItem *tags)
 {
+  if (m_pImage)
+    m_pImage->SetResolutionLevels(tags->GetTagData(JPGTAG_DECODER_RESOLUTION_LEVELS));
+  
   if (tags->GetTagData(JPGTAG_MATRIX_LTRAFO,JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR) == 
       JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE) {
     if (m_pImage) {
@@ -48,7 +48,12 @@
 #include "control/bufferctrl.hpp"
 #include "control/residualbuffer.hpp"
 #include "control/hierarchicalbitmaprequester.hpp"
+#include "control/blockbitmaprequester.hpp"
+#include "marker/scan.hpp"
+#include "marker/component.hpp"
 #include "boxes/checksumbox.hpp"
+#include "boxes/mergingspecbox.hpp"
+#include "boxes/dctbox.hpp"
 ///
 
 /// Forwards
@@ -68,7 +73,7 @@ Image::Image(class Environ *env)
     m_pLast(NULL), m_pCurrent(NULL), m_pImageBuffer(NULL), 
     m_pResidualImage(NULL), m_pChecksum(NULL), 
     m_pLegacyStream(NULL), m_pAdapter(NULL), m_pBoxList(NULL),
-    m_bReceivedFrameHeader(false)
+    m_bReceivedFrameHeader(false), m_ulRequestedLevels(0), m_bTruncated(false)
 {
 }
 ///
@@ -166,6 +171,171 @@ class Tables *Image::TablesOf(void)
 }
 ///
 
+/// Image::ResolutionLevelsOf
+// Return the number of resolution levels, i.e. frames of a hierarchical
+// image, parsed so far. This is one for a non-hierarchical image.
+ULONG Image::ResolutionLevelsOf(void) const
+{
+  class Frame *frame = m_pSmallest;
+  ULONG levels       = 0;
+
+  if (frame == NULL)
+    return (m_pDimensions)?(1):(0);
+
+  while(frame) {
+    levels++;
+    frame = frame->NextOf();
+  }
+
+  return levels;
+}
+///
+
+/// Image::EnableRowRecycling
+// Check whether the frame the given scan is the first scan of can be
+// reconstructed while it is decoded, and if so, instruct the image
+// buffer to release coefficient rows as soon as they are reconstructed.
+// This requires a non-hierarchical sequential frame that consists of a
+// single scan containing all components, without residual, refinement
+// or alpha data. Returns true if row recycling is enabled.
+bool Image::EnableRowRecycling(class Scan *scan)
+{
+  //
+  // Only for the main image. Residual and alpha are decoded after the
+  // legacy image and require its coefficients.
+  if (m_pParent || m_pMaster || m_pSmallest || m_pImageBuffer == NULL || m_pCurrent == NULL)
+    return false;
+  //
+  // Line based buffers do not buffer coefficients.
+  if (m_pImageBuffer->isLineBased())
+    return false;
+  //
+  switch(m_pCurrent->ScanTypeOf()) {
+  case Baseline:
+  case Sequential:
+  case ACSequential:
+    break;
+  default:
+    // Progressive scans revisit all rows, others are line based.
+    return false;
+  }
+  //
+  // A sequential frame is completed by a single scan if and only if
+  // this scan contains all components.
+  if (scan != m_pCurrent->FirstScanOf() || scan->ComponentsInScan() != m_pCurrent->DepthOf())
+    return false;
+  //
+  // Hidden refinement scans, residual and alpha data are decoded later and
+  // refer to the coefficients or require lock-step reconstruction.
+  if (m_pTables->HiddenDCTBitsOf() > 0   || m_pTables->ResidualDataOf() ||
+      m_pTables->ResidualSpecsOf()       || m_pTables->AlphaDataOf()    ||
+      m_pTables->AlphaSpecsOf())
+    return false;
+  //
+  ((class BlockBitmapRequester *)m_pImageBuffer)->EnableRowRecycling();
+  return true;
+}
+///
+
+/// Image::CoefficientRowOf
+// Return the row of quantized coefficients of the given component at
+// the given block row, or NULL if the row has not yet been decoded.
+// This is only available for non-hierarchical DCT based images.
+const class QuantizedRow *Image::CoefficientRowOf(UBYTE comp,ULONG row)
+{
+  if (m_pDimensions == NULL || m_pImageBuffer == NULL)
+    return NULL;
+
+  if (m_pSmallest || m_pImageBuffer->isLineBased())
+    JPG_THROW(NOT_IMPLEMENTED,"Image::CoefficientRowOf",
+              "coefficients are only available for non-hierarchical DCT based images");
+
+  return ((class BlockBitmapRequester *)m_pImageBuffer)->CoefficientRowOf(comp,row);
+}
+///
+
+/// Image::isTranscodableType
+// Check whether the given frame type holds its data in the DCT domain
+// and can thus be the source or target of a transcoding operation.
+bool Image::isTranscodableType(ScanType type)
+{
+  switch(type) {
+  case Baseline:
+  case Sequential:
+  case Progressive:
+  case ACSequential:
+  case ACProgressive:
+    return true;
+  default:
+    return false;
+  }
+}
+///
+
+/// Image::ImportCoefficients
+// Copy the quantized DCT coefficients and the quantization tables of
+// a fully decoded source image into this image that has been set up
+// for encoding, bypassing the color transformation and the DCT. This
+// allows lossless transcoding between DCT based frame types. Both
+// images must be non-hierarchical, free of residual and alpha data,
+// and agree in dimensions, precision and subsampling.
+void Image::ImportCoefficients(const class Image *source)
+{
+  class MergingSpecBox *specs;
+  UBYTE i;
+  
+  if (m_pDimensions == NULL || m_pImageBuffer == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"Image::ImportCoefficients",
+              "no image constructed into which coefficients could be imported");
+  
+  if (source->m_pDimensions == NULL || source->m_pImageBuffer == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"Image::ImportCoefficients",
+              "no source image available from which coefficients could be imported");
+
+  if (m_pSmallest || source->m_pSmallest || m_pResidual || source->m_pResidual ||
+      m_pAlphaChannel || source->m_pAlphaChannel)
+    JPG_THROW(NOT_IMPLEMENTED,"Image::ImportCoefficients",
+              "transcoding hierarchical images or images with residual or alpha data is not supported");
+
+  //
+  // Hidden refinement bits are not part of the legacy coefficients, and
+  // any other DCT than the regular one cannot be signalled without the
+  // specs box.
+  specs = source->m_pTables->ResidualSpecsOf();
+  if (source->m_pTables->HiddenDCTBitsOf() > 0 || source->m_pTables->ResidualDataOf() ||
+      source->m_pTables->AlphaDataOf() || m_pTables->HiddenDCTBitsOf() > 0 ||
+      (specs && specs->LDCTProcessOf() != DCTBox::FDCT))
+    JPG_THROW(NOT_IMPLEMENTED,"Image::ImportCoefficients",
+              "transcoding images with refinement, residual or alpha data is not supported");
+  
+  if (!isTranscodableType(m_pDimensions->ScanTypeOf()) || !isTranscodableType(source->m_pDimensions->ScanTypeOf()))
+    JPG_THROW(INVALID_PARAMETER,"Image::ImportCoefficients",
+              "transcoding is only possible between DCT based frame types");
+
+  if (m_pDimensions->WidthOf() != source->WidthOf() || m_pDimensions->HeightOf() != source->HeightOf() ||
+      m_pDimensions->DepthOf() != source->DepthOf() ||
+      m_pDimensions->PrecisionOf() != source->m_pDimensions->PrecisionOf())
+    JPG_THROW(INVALID_PARAMETER,"Image::ImportCoefficients",
+              "dimensions or precision of the source image do not match the dimensions of the target");
+
+  for(i = 0;i < m_pDimensions->DepthOf();i++) {
+    class Component *dst = m_pDimensions->ComponentOf(i);
+    class Component *src = source->m_pDimensions->ComponentOf(i);
+    if (dst->SubXOf() != src->SubXOf() || dst->SubYOf() != src->SubYOf())
+      JPG_THROW(INVALID_PARAMETER,"Image::ImportCoefficients",
+                "subsampling factors of the source image do not match the subsampling of the target");
+    dst->SetQuantizer(src->QuantizerOf());
+  }
+  //
+  // The coefficients are quantized, hence the tables must be identical.
+  m_pTables->ImportQuantizationTables(source->m_pTables);
+  //
+  // Non-hierarchical DCT based frames always use a block based buffer.
+  ((class BlockBitmapRequester *)m_pImageBuffer)->
+    ImportCoefficients((class BlockBitmapRequester *)source->m_pImageBuffer);
+}
+///
+
 /// Image::InstallDefaultParameters
 // Define default scan parameters. Returns the frame smallest frame or the only frame.
 // Levels is the number of decomposition levels for the hierarchical mode. It is zero
@@ -1391,6 +1561,16 @@ bool Image::ParseTrailer(class ByteStream *io)
   // First, note that the frame header is required again now.
   m_bReceivedFrameHeader = false;
   //
+  // If only some resolution levels of a hierarchical image are requested,
+  // stop here when they are all available and more frames would follow.
+  if (m_pSmallest && m_ulRequestedLevels && m_pParent == NULL && m_pMaster == NULL) {
+    if (ResolutionLevelsOf() >= m_ulRequestedLevels && io->PeekWord() != 0xffd9) {
+      ((class HierarchicalBitmapRequester *)m_pImageBuffer)->RestrictToLargestScale();
+      m_bTruncated = true;
+      return false;
+    }
+  }
+  //
   do {
     LONG marker = io->PeekWord();
     
@@ -124,6 +124,15 @@ class Image : public JKeeper {
   // whether there is another frame.
   bool                   m_bReceivedFrameHeader;
   //
+  // Number of resolution levels of a hierarchical image the decoder
+  // shall parse, starting at the smallest level. Zero parses all levels.
+  ULONG                  m_ulRequestedLevels;
+  //
+  // Set if decoding of a hierarchical image stopped at an intermediate
+  // resolution level. The image dimensions are then those of the largest
+  // frame decoded.
+  bool                   m_bTruncated;
+  //
   // Create the buffer providing an access path to the residuals, if available.
   // This works only for block based modes, line based modes do not create 
   // residuals.
@@ -144,6 +153,10 @@ class Image : public JKeeper {
   // and hence can only be used in a hierarchical JPEG.
   static bool isDifferentialType(ScanType type);
   //
+  // Check whether the given frame type holds its data in the DCT domain
+  // and can thus be the source or target of a transcoding operation.
+  static bool isTranscodableType(ScanType type);
+  //
   // Select the first frame to write to, return it.
   class Frame *FindFirstWriteFrame(void) const;
   //
@@ -190,6 +203,39 @@ public:
     return false;
   }
   //
+  // Restrict decoding of a hierarchical image to the given number of
+  // resolution levels, starting at the smallest level. Zero decodes all
+  // levels, which is also the default.
+  void SetResolutionLevels(ULONG levels)
+  {
+    m_ulRequestedLevels = levels;
+  }
+  //
+  // Return the number of resolution levels, i.e. frames of a hierarchical
+  // image, parsed so far. This is one for a non-hierarchical image.
+  ULONG ResolutionLevelsOf(void) const;
+  //
+  // Check whether the frame the given scan is the first scan of can be
+  // reconstructed while it is decoded, and if so, instruct the image
+  // buffer to release coefficient rows as soon as they are reconstructed.
+  // This requires a non-hierarchical sequential frame that consists of a
+  // single scan containing all components, without residual, refinement
+  // or alpha data. Returns true if row recycling is enabled.
+  bool EnableRowRecycling(class Scan *scan);
+  //
+  // Copy the quantized DCT coefficients and the quantization tables of
+  // a fully decoded source image into this image that has been set up
+  // for encoding, bypassing the color transformation and the DCT. This
+  // allows lossless transcoding between DCT based frame types. Both
+  // images must be non-hierarchical, free of residual and alpha data,
+  // and agree in dimensions, precision and subsampling.
+  void ImportCoefficients(const class Image *source);
+  //
+  // Return the row of quantized coefficients of the given component at
+  // the given block row, or NULL if the row has not yet been decoded.
+  // This is only available for non-hierarchical DCT based images.
+  const class QuantizedRow *CoefficientRowOf(UBYTE comp,ULONG row);
+  //
   // Return the alpha channel if we have one.
   class Image *AlphaChannelOf(void) const
   {
@@ -201,6 +247,8 @@ public:
   {
     if (m_pDimensions == NULL)
       JPG_THROW(OBJECT_DOESNT_EXIST,"Image::WidthOf","no image created or loaded");
+    if (m_bTruncated)
+      return m_pLast->WidthOf();
     return m_pDimensions->WidthOf();
   }
   //
@@ -212,6 +260,9 @@ public:
     if (m_pDimensions == NULL)
       JPG_THROW(OBJECT_DOESNT_EXIST,"Image::HeightOf","no image created or loaded");
     
+    if (m_bTruncated)
+      return m_pLast->HeightOf();
+    
     height = m_pDimensions->HeightOf();
     //
     // If the DNL marker is used, it might be that this is zero. In this case,
@@ -0,0 +1,379 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams.
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This class scans the markers of a JPEG stream up to the first scan
+** header and collects the image properties without building any of
+** the decoder structures.
+**
+*/
+
+/// Include
+#include "codestream/probe.hpp"
+#include "io/bytestream.hpp"
+#include "std/assert.hpp"
+#include "std/string.hpp"
+#include "interface/tagitem.hpp"
+#include "interface/parameters.hpp"
+#include "boxes/box.hpp"
+#include "boxes/databox.hpp"
+#include "boxes/filetypebox.hpp"
+#include "boxes/mergingspecbox.hpp"
+///
+
+/// Probe::Probe
+Probe::Probe(class Environ *env)
+  : JKeeper(env), m_ulWidth(0), m_ulHeight(0), m_ucPrecision(0), m_ucDepth(0),
+    m_lFrameType(0), m_lProfile(0), m_bFrame(false), m_bHierarchical(false),
+    m_bResidual(false), m_bAlpha(false)
+{
+  memset(m_ucSubX,1,sizeof(m_ucSubX));
+  memset(m_ucSubY,1,sizeof(m_ucSubY));
+}
+///
+
+/// Probe::ParseFrameHeader
+// Parse a frame header, or the DHP marker, from the stream. The marker
+// itself is already parsed off.
+void Probe::ParseFrameHeader(class ByteStream *io,LONG marker)
+{
+  LONG len = io->GetWord();
+  UBYTE mcux[4],mcuy[4];
+  UBYTE maxx = 1,maxy = 1;
+  LONG data;
+  int i;
+
+  switch(marker) {
+  case 0xffc0:
+    m_lFrameType = JPGFLAG_BASELINE;
+    break;
+  case 0xffc1:
+  case 0xffc5:
+    m_lFrameType = JPGFLAG_SEQUENTIAL;
+    break;
+  case 0xffc2:
+  case 0xffc6:
+    m_lFrameType = JPGFLAG_PROGRESSIVE;
+    break;
+  case 0xffc3:
+  case 0xffc7:
+    m_lFrameType = JPGFLAG_LOSSLESS;
+    break;
+  case 0xffc9:
+  case 0xffcd:
+    m_lFrameType = JPGFLAG_SEQUENTIAL  | JPGFLAG_ARITHMETIC;
+    break;
+  case 0xffca:
+  case 0xffce:
+    m_lFrameType = JPGFLAG_PROGRESSIVE | JPGFLAG_ARITHMETIC;
+    break;
+  case 0xffcb:
+  case 0xffcf:
+    m_lFrameType = JPGFLAG_LOSSLESS    | JPGFLAG_ARITHMETIC;
+    break;
+  case 0xfff7:
+    m_lFrameType = JPGFLAG_JPEG_LS;
+    break;
+  case 0xffde: // DHP, delivers the dimensions, but not the frame type.
+    m_bHierarchical = true;
+    break;
+  }
+
+  if (len < 8)
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","start of frame marker size invalid");
+  //
+  // In a hierarchical process, the dimensions come from the DHP marker,
+  // and the frames only define the frame type.
+  if (m_bFrame) {
+    io->SkipBytes(len - 2);
+    return;
+  }
+
+  data = io->Get();
+  if (data == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+  //
+  // Same precision limits as in Frame::ParseMarker.
+  switch(marker) {
+  case 0xffc3:
+  case 0xffc7:
+  case 0xffcb:
+  case 0xffcf:
+  case 0xfff7:
+    if (data < 2 || data > 16)
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader",
+                "frame precision in lossless mode must be between 2 and 16");
+    break;
+  case 0xffc0:
+    if (data != 8)
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","frame precision in baseline mode must be 8");
+    break;
+  default:
+    if (data != 8 && data != 12)
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","frame precision in lossy mode must be 8 or 12");
+    break;
+  }
+  m_ucPrecision = data;
+
+  data = io->GetWord();
+  if (data == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+  m_ulHeight = data;
+
+  data = io->GetWord();
+  if (data == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+  if (data == 0)
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","image width must not be zero");
+  m_ulWidth = data;
+
+  data = io->Get();
+  if (data == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+  if (data <= 0 || data > 255)
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","number of components must be between 1 and 255");
+  m_ucDepth = data;
+
+  if (len - 8 != 3 * m_ucDepth)
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","frame header marker size is invalid");
+
+  for(i = 0;i < m_ucDepth;i++) {
+    if (io->Get() == ByteStream::EOF) // the component identifier
+      JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+    data = io->Get();
+    if (data == ByteStream::EOF)
+      JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+    if (io->Get() == ByteStream::EOF) // the quantization table
+      JPG_THROW(UNEXPECTED_EOF,"Probe::ParseFrameHeader","frame marker run out of data");
+    if ((data >> 4) < 1 || (data >> 4) > 4 || (data & 0x0f) < 1 || (data & 0x0f) > 4)
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseFrameHeader","MCU dimensions must be between 1 and 4");
+    if ((data >> 4)   > maxx)
+      maxx = data >> 4;
+    if ((data & 0x0f) > maxy)
+      maxy = data & 0x0f;
+    if (i < 4) {
+      mcux[i] = data >> 4;
+      mcuy[i] = data & 0x0f;
+    }
+  }
+  //
+  // Convert the MCU dimensions into subsampling factors.
+  for(i = 0;i < m_ucDepth && i < 4;i++) {
+    m_ucSubX[i] = maxx / mcux[i];
+    m_ucSubY[i] = maxy / mcuy[i];
+  }
+
+  m_bFrame = true;
+}
+///
+
+/// Probe::ParseBoxMarker
+// Parse an APP11 marker segment carrying a JPEG XT box, or a part of
+// it. The marker itself is already parsed off.
+void Probe::ParseBoxMarker(class ByteStream *io)
+{
+  LONG len      = io->GetWord();
+  LONG overhead = 2 + 2 + 2 + 4 + 4 + 4;
+  ULONG z,lbox,tbox;
+  LONG dt;
+
+  if (len == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseBoxMarker","marker incomplete, stream truncated");
+  if (len <= 2)
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseBoxMarker","marker size out of range");
+  //
+  // Everything that is not a box is skipped.
+  if (len <= overhead || io->PeekWord() != 0x4a50) {
+    io->SkipBytes(len - 2);
+    return;
+  }
+  io->GetWord(); // the common identifier
+  io->GetWord(); // the box instance number
+  z     = io->GetWord() << 16;
+  z    |= io->GetWord();
+  lbox  = io->GetWord() << 16;
+  lbox |= io->GetWord();
+  tbox  = io->GetWord() << 16;
+  dt    = io->GetWord();
+  if (dt == ByteStream::EOF)
+    JPG_THROW(UNEXPECTED_EOF,"Probe::ParseBoxMarker","JPEG stream is malformed, unexpected "
+              "end of file while parsing an APP11 marker");
+  tbox |= dt;
+  //
+  if (lbox == 1) {
+    overhead += 8;
+    if (len <= overhead)
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseBoxMarker","JPEG stream is malformed, "
+                "APP11 extended box marker size is too short.");
+    io->SkipBytes(8);
+  }
+  len -= overhead;
+
+  switch(tbox) {
+  case DataBox::ResidualType:
+    m_bResidual = true;
+    break;
+  case DataBox::AlphaType:
+  case MergingSpecBox::AlphaType:
+    m_bAlpha    = true;
+    break;
+  case FileTypeBox::Type:
+    // Only the first segment starts with the brand and the minor version,
+    // followed by the compatibility list which includes the profile.
+    if (z == 1 && len >= 4 + 4) {
+      io->SkipBytes(4 + 4);
+      len -= 4 + 4;
+      while(len >= 4 && m_lProfile == 0) {
+        ULONG id;
+        id  = io->GetWord() << 16;
+        dt  = io->GetWord();
+        if (dt == ByteStream::EOF)
+          JPG_THROW(UNEXPECTED_EOF,"Probe::ParseBoxMarker","marker incomplete, stream truncated");
+        id |= dt;
+        len -= 4;
+        switch(id) {
+        case FileTypeBox::XT_IDR:
+        case FileTypeBox::XT_HDR_A:
+        case FileTypeBox::XT_HDR_B:
+        case FileTypeBox::XT_HDR_C:
+        case FileTypeBox::XT_HDR_D:
+        case FileTypeBox::XT_LS:
+          m_lProfile = id;
+          break;
+        }
+      }
+    }
+    break;
+  }
+  //
+  // Skip the payload.
+  if (len > 0)
+    io->SkipBytes(len);
+}
+///
+
+/// Probe::ParseHeader
+// Scan the stream from the SOI marker up to and including the first
+// SOS marker. Throws if the stream is not a JPEG stream.
+void Probe::ParseHeader(class ByteStream *io)
+{
+  LONG marker = io->GetWord();
+
+  if (marker != 0xffd8) // SOI
+    JPG_THROW(MALFORMED_STREAM,"Probe::ParseHeader","stream does not contain a JPEG file, SOI marker missing");
+
+  do {
+    marker = io->PeekWord();
+    if (marker == 0xffff) {
+      // A filler byte followed by a marker. Skip.
+      io->Get();
+      continue;
+    }
+    io->GetWord();
+    switch(marker) {
+    case ByteStream::EOF:
+      JPG_THROW(UNEXPECTED_EOF,"Probe::ParseHeader","unexpected EOF while parsing the image header");
+      break;
+    case 0xffd9: // EOI
+      JPG_THROW(MALFORMED_STREAM,"Probe::ParseHeader","unexpected EOI, expected a frame header");
+      break;
+    case 0xffda: // SOS, done.
+      if (!m_bFrame)
+        JPG_THROW(MALFORMED_STREAM,"Probe::ParseHeader","found a scan header outside of a frame");
+      break;
+    case 0xffc0:
+    case 0xffc1:
+    case 0xffc2:
+    case 0xffc3:
+    case 0xffc5:
+    case 0xffc6:
+    case 0xffc7:
+    case 0xffc9:
+    case 0xffca:
+    case 0xffcb:
+    case 0xffcd:
+    case 0xffce:
+    case 0xffcf:
+    case 0xfff7:
+    case 0xffde:
+      ParseFrameHeader(io,marker);
+      break;
+    case 0xffeb: // APP11: Maybe the box marker.
+      ParseBoxMarker(io);
+      break;
+    case 0xffd0:
+    case 0xffd1:
+    case 0xffd2:
+    case 0xffd3:
+    case 0xffd4:
+    case 0xffd5:
+    case 0xffd6:
+    case 0xffd7:
+    case 0xff01: // Restart markers and TEM carry no data.
+      break;
+    default:
+      if (marker >= 0xffc0) {
+        LONG size = io->GetWord();
+        if (size == ByteStream::EOF)
+          JPG_THROW(UNEXPECTED_EOF,"Probe::ParseHeader","marker incomplete, stream truncated");
+        if (size <= 0x02)
+          JPG_THROW(MALFORMED_STREAM,"Probe::ParseHeader","marker size out of range");
+        io->SkipBytes(size - 2);
+      } else {
+        JPG_THROW(MALFORMED_STREAM,"Probe::ParseHeader","found invalid marker, stream is corrupt");
+      }
+      break;
+    }
+  } while(marker != 0xffda);
+}
+///
+
+/// Probe::GetInformation
+// Deliver the collected information in the tags.
+void Probe::GetInformation(struct JPG_TagItem *tags) const
+{
+  struct JPG_TagItem *subx = tags->FindTagItem(JPGTAG_IMAGE_SUBX);
+  struct JPG_TagItem *suby = tags->FindTagItem(JPGTAG_IMAGE_SUBY);
+  LONG type = m_lFrameType;
+
+  if (m_bHierarchical)
+    type |= JPGFLAG_PYRAMIDAL;
+  if (m_bResidual)
+    type |= JPGFLAG_RESIDUAL_CODING;
+
+  tags->SetTagData(JPGTAG_IMAGE_WIDTH    ,m_ulWidth);
+  tags->SetTagData(JPGTAG_IMAGE_HEIGHT   ,m_ulHeight);
+  tags->SetTagData(JPGTAG_IMAGE_DEPTH    ,m_ucDepth);
+  tags->SetTagData(JPGTAG_IMAGE_PRECISION,m_ucPrecision);
+  tags->SetTagData(JPGTAG_IMAGE_FRAMETYPE,type);
+  tags->SetTagData(JPGTAG_IMAGE_HAS_ALPHA,m_bAlpha);
+  tags->SetTagData(JPGTAG_PROFILE        ,m_lProfile);
+
+  if (subx && subx->ti_Data.ti_pPtr)
+    memcpy(subx->ti_Data.ti_pPtr,m_ucSubX,sizeof(m_ucSubX));
+  if (suby && suby->ti_Data.ti_pPtr)
+    memcpy(suby->ti_Data.ti_pPtr,m_ucSubY,sizeof(m_ucSubY));
+}
+///
@@ -0,0 +1,112 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams.
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+** This class scans the markers of a JPEG stream up to the first scan
+** header and collects the image properties without building any of
+** the decoder structures.
+**
+*/
+
+#ifndef CODESTREAM_PROBE_HPP
+#define CODESTREAM_PROBE_HPP
+
+/// Include
+#include "interface/types.hpp"
+#include "tools/environment.hpp"
+///
+
+/// Forwards
+class ByteStream;
+struct JPG_TagItem;
+///
+
+/// class Probe
+// This class scans the markers of a JPEG stream from the SOI up to the
+// first SOS marker, skipping over the marker payloads it does not need,
+// and collects the image geometry, the frame type and which JPEG XT
+// extensions are present. Unlike the decoder, it neither creates an
+// image nor tables, frames or boxes.
+class Probe : public JKeeper {
+  //
+  // Dimensions of the image in pixels. The height may be zero if it is
+  // defined by a DNL marker.
+  ULONG m_ulWidth;
+  ULONG m_ulHeight;
+  //
+  // Sample precision in bits as signalled in the frame header.
+  UBYTE m_ucPrecision;
+  //
+  // Number of components.
+  UBYTE m_ucDepth;
+  //
+  // Subsampling factors of the first four components.
+  UBYTE m_ucSubX[4];
+  UBYTE m_ucSubY[4];
+  //
+  // The frame type in terms of the JPGFLAG_ frame type flags.
+  LONG  m_lFrameType;
+  //
+  // The JPEG XT profile from the file type box, or zero.
+  LONG  m_lProfile;
+  //
+  // Set if a frame header has been found.
+  bool  m_bFrame;
+  //
+  // Set if a hierarchical process has been detected by a DHP marker.
+  bool  m_bHierarchical;
+  //
+  // Set if JPEG XT residual data is present.
+  bool  m_bResidual;
+  //
+  // Set if a JPEG XT alpha channel is present.
+  bool  m_bAlpha;
+  //
+  // Parse a frame header, or the DHP marker, from the stream. The marker
+  // itself is already parsed off.
+  void ParseFrameHeader(class ByteStream *io,LONG marker);
+  //
+  // Parse an APP11 marker segment carrying a JPEG XT box, or a part of
+  // it. The marker itself is already parsed off.
+  void ParseBoxMarker(class ByteStream *io);
+  //
+public:
+  Probe(class Environ *env);
+  //
+  ~Probe(void)
+  {
+  }
+  //
+  // Scan the stream from the SOI marker up to and including the first
+  // SOS marker. Throws if the stream is not a JPEG stream.
+  void ParseHeader(class ByteStream *io);
+  //
+  // Deliver the collected information in the tags.
+  void GetInformation(struct JPG_TagItem *tags) const;
+};
+///
+
+///
+#endif
@@ -48,6 +48,7 @@
 #include "interface/imagebitmap.hpp"
 #include "colortrafo/colortrafo.hpp"
 #include "tools/traits.hpp"
+#include "tools/numerics.hpp"
 #include "control/blockbuffer.hpp"
 #include "control/blockbitmaprequester.hpp"
 #include "control/blocklineadapter.hpp"
@@ -560,6 +561,27 @@ void RefinementScan::EncodeBlock(const LONG *block,class HuffmanCoder *ac,UWORD
 }
 ///
 
+/// RefinementScan::RefineBlock
+// Read the correction bits of all coefficients whose scan indices are
+// set in the given mask. These coefficients are all significant.
+void RefinementScan::RefineBlock(LONG *block,UQUAD mask)
+{
+  while(mask) {
+    int k = LowestBitOf(mask);
+    mask &= mask - 1;
+    if (m_Stream.Get<1>()) {
+      // Correction necessary. The direction depends on the
+      // sign. We always correct "away from the origin".
+      if (block[DCT::ScanOrder[k]] > 0) {
+        block[DCT::ScanOrder[k]] += 1L << m_ucLowBit;
+      } else {
+        block[DCT::ScanOrder[k]] -= 1L << m_ucLowBit;
+      }
+    }
+  }
+}
+///
+
 /// RefinementScan::DecodeBlock
 // Decode a single huffman block.
 void RefinementScan::DecodeBlock(LONG *block,
@@ -573,100 +595,90 @@ void RefinementScan::DecodeBlock(LONG *block,
   }
 
   if (m_ucScanStop || m_bResidual) {
-    int k = m_ucScanStart;
-    UBYTE run = 0;
-    LONG  s   = 0;      // significance available? Positive? Negative?
+    int   k;
+    UQUAD band; // all coefficients of the band from k on.
+    UQUAD nz;   // the significant coefficients, one bit per scan index.
     //
     assert(m_ucScanStart || m_bResidual); // AC coding must be separate from DC coding.
     //
+    // Collect the significant coefficients first. This does not branch,
+    // all further runs and refinements are then bit scans over the mask.
+    band = ((UQUAD(2) << m_ucScanStop) - 1) & (~UQUAD(0) << m_ucScanStart);
+    nz   = 0;
+    for(k = m_ucScanStart;k <= m_ucScanStop;k++) {
+      nz |= UQUAD(block[DCT::ScanOrder[k]] != 0) << k;
+    }
+    //
     if (skip > 0) {
       // The entire block is skipped, decode only the refinement bits.
-      run = m_ucScanStop - m_ucScanStart + 1;
       skip--;  // Still blocks to skip
-    } else {
-      k--;
-      goto start; // Not elegant, but efficient.
+      RefineBlock(block,nz);
+      return;
     }
     //
     do {
-      LONG data;
-      // Skip coefficients, but for those that were significant,
-      // collect refinement bits which we know are available because
-      // we are currently parsing off the trailer of either an EOB
-      // or of a EOBx.
-      if ((data = block[DCT::ScanOrder[k]])) {
-        UBYTE correction = m_Stream.Get<1>();
-        if (correction) {
-          // Correction necessary. The direction depends on the
-          // sign. We always correct "away from the origin".
-          if (data > 0) {
-            block[DCT::ScanOrder[k]] += 1L << m_ucLowBit;
-          } else {
-            block[DCT::ScanOrder[k]] -= 1L << m_ucLowBit;
-          }
+      UQUAD zero;
+      UBYTE r,rs;
+      LONG  s;
+      //
+      // Get the next run/amplitude pair. This can be either an EOBx symbol
+      // for skipping this and the next x blocks, or a run16 symbol to skip
+      // the next 16 blocks without any amplitude, or a true run/amplitude
+      // pair.
+      rs    = ac->Get(&m_Stream);
+      r     = rs >> 4;
+      s     = rs & 0x0f;
+      if (s == 0) {
+        // This is a pure skip without an amplitude pair.
+        if (r != 15) {
+          // A progressive EOB run.
+          skip  = 1 << r;
+          if (r) skip |= m_Stream.Get(r);
+          skip--; // this block is included in the count.
+          // Skip the rest of the block, though not for the refinement bits.
+          RefineBlock(block,nz & band);
+          return;
         }
-      } else if (run) {
-        // Still in the run.
-        run--;
+        // Otherwise, a ZRL run. No typo, the 16th coefficient is s = 0.
+      } else if (s != 1) {
+        // A run/amplitude pair. Only +/-1 amplitudes may appear here.
+        JPG_WARN(MALFORMED_STREAM,"RefinementScan::DecodeBlock",
+                 "unexpected Huffman symbol in refinement coding, "
+                 "must be a +/-1 amplitude");
+        // Ok, to recover, do not refine here at all, we are out of sync
+        // anyhow. Rather, leave the modification as local as possible
+        // and decode as fast as possible so decoding will stop at the 
+        // next restart marker.
+        r = 0;
+        s = 0;
       } else {
-        // Run ended, decode the coefficient that ends the run. If
-        // we have a significant coefficient, decode it here. This
-        // also covers the case of the last element of a ZRL run.
-        // Then s is simply zero.
-        block[DCT::ScanOrder[k]] = s << m_ucLowBit; 
-        //
-        // If this is the last coefficent, then there is nothing more to do
-        // on this block.
-        if (k == m_ucScanStop)
-          break;
-        //
-        // Get the next run/amplitude pair. This can be either an EOBx symbol
-        // for skipping this and the next x blocks, or a run16 symbol to skip
-        // the next 16 blocks without any amplitude, or a true run/amplitude
-        // pair.
-      start:
-        UBYTE r,rs;
-        rs    = ac->Get(&m_Stream);
-        r     = rs >> 4;
-        s     = rs & 0x0f;
-        if (s == 0) {
-          // This is a pure skip without an amplitude pair.
-          if (r == 15) {
-            run   = r; // No typo, the 16th coefficient is s = 0.
-          } else {
-            // A progressive EOB run.
-            skip  = 1 << r;
-            if (r) skip |= m_Stream.Get(r);
-            skip--; // this block is included in the count.
-            run   = m_ucScanStop - k + 1; // Skip the rest of the block,
-            // though not for the refinement bits.
-          }
-        } else {
-          UBYTE sign;
-          // A run/amplitude pair. Only +/-1 amplitudes may appear here.
-          if (s != 1) {
-            JPG_WARN(MALFORMED_STREAM,"RefinementScan::DecodeBlock",
-                     "unexpected Huffman symbol in refinement coding, "
-                     "must be a +/-1 amplitude");
-            // Ok, to recover, do not refine here at all, we are out of sync
-            // anyhow. Rather, leave the modification as local as possible
-            // and decode as fast as possible so decoding will stop at the 
-            // next restart marker.
-            run = 0;
-            s   = 0;
-          } else {
-            //
-            sign = m_Stream.Get<1>();
-            // Get the sign of the coefficient. Zero is for negative.
-            if (sign == 0)
-              s = -s;
-            // Note that we cannot apply the bits itself now. Must skip the coefficients
-            // handled here.
-            run = r;
-          }
-        }
+        // Get the sign of the coefficient. Zero is for negative.
+        if (m_Stream.Get<1>() == 0)
+          s = -s;
       }
-    } while(++k <= m_ucScanStop);
+      //
+      // Find the coefficient that ends the run, i.e. the r+1th
+      // insignificant coefficient.
+      zero = band & ~nz;
+      while(r && zero) {
+        zero &= zero - 1;
+        r--;
+      }
+      if (zero == 0) {
+        // The run extends beyond the band, only the refinement
+        // bits remain.
+        RefineBlock(block,nz & band);
+        return;
+      }
+      k     = LowestBitOf(zero);
+      // Note that we cannot apply the bits itself now. Must first 
+      // refine the coefficients skipped over by the run.
+      RefineBlock(block,nz & band & ((UQUAD(1) << k) - 1));
+      block[DCT::ScanOrder[k]] = s << m_ucLowBit;
+      //
+      // Continue behind this coefficient.
+      band &= (~UQUAD(1)) << k;
+    } while(band);
   }
 }
 ///
@@ -119,6 +119,10 @@ protected:
   virtual void Restart(void);
   //
 private:
+  //
+  // Read the correction bits of all coefficients whose scan indices are
+  // set in the given mask.
+  void RefineBlock(LONG *block,UQUAD mask);
   //
   // Make a block statistics measurement on the source data.
   void MeasureBlock(const LONG *block,
@@ -86,7 +86,7 @@ Tables::Tables(class Environ *env)
     m_pThresholds(NULL), m_pLSColorTrafo(NULL), m_pResidualSpecs(NULL), m_pAlphaSpecs(NULL),
     m_pIdentityMapping(NULL), m_pChecksumBox(NULL),
     m_ucMaxError(0), m_bDisableColor(false), m_bTruncateColor(false), m_bRefinement(false), 
-    m_bOpenLoop(false), m_bDeadZone(false),
+    m_bOpenLoop(false), m_bDeadZone(false), m_usOptimizeQuant(0),
     m_bFoundExp(false), m_bHorizontalExpansion(false), m_bVerticalExpansion(false)
 
 {
@@ -251,9 +251,18 @@ void Tables::InstallDefaultTables(UBYTE precision,UBYTE rangebits,const struct J
   if (m_pParent) {
     m_bOpenLoop = m_pParent->m_bOpenLoop;
     m_bDeadZone = m_pParent->m_bDeadZone;
+    // The rate estimate is only available for the legacy codestream.
+    m_usOptimizeQuant = 0;
   } else {
     m_bOpenLoop = tags->GetTagData(JPGTAG_OPENLOOP_ENCODER)?true:false;
     m_bDeadZone = tags->GetTagData(JPGTAG_DEADZONE_QUANTIZER)?true:false;
+    m_usOptimizeQuant = UWORD(tags->GetTagData(JPGTAG_OPTIMIZE_QUANTIZER));
+    //
+    // The rate is estimated from the default 8-bit Huffman tables. These
+    // say little about the rate of the larger symbols of other precisions
+    // nor about the rate of the arithmetic coder, hence disable it there.
+    if (precision != 8 || (frametype & JPGFLAG_ARITHMETIC))
+      m_usOptimizeQuant = 0;
   }
   //
   // Install the maximum error.
@@ -1123,6 +1132,7 @@ void Tables::ParseTables(class ByteStream *io,class Checksum *chk,bool allowexp)
         io->GetWord();
         LONG len = io->GetWord();
         if (len >= 2 + 2 + 2 + 4 + 4 + 4) { // At least the box header must be present.
+          io->Prefetch(len); // the rest of the segment and the next marker.
           LONG ci = io->PeekWord();
           if (ci == 0x4a50) { 
             class Box *box;
@@ -1426,6 +1436,25 @@ const UWORD *Tables::FindQuantizationTable(UBYTE idx) const
 }
 ///
 
+/// Tables::ImportQuantizationTables
+// Replace all quantization tables by those of the given tables,
+// for re-encoding quantized data without requantization.
+void Tables::ImportQuantizationTables(const class Tables *source)
+{
+  UBYTE i;
+  
+  if (source->m_pQuant == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"Tables::ImportQuantizationTables","DQT marker missing, no quantization table defined");
+
+  if (m_pQuant == NULL)
+    m_pQuant = new(m_pEnviron) Quantization(m_pEnviron);
+
+  for(i = 0;i < 4;i++) {
+    m_pQuant->DefineTable(i,source->m_pQuant->QuantizationTable(i));
+  }
+}
+///
+
 /// Tables::ColorTrafoOf
 // Return the color transformer.
 class ColorTrafo *Tables::ColorTrafoOf(class Frame *frame,class Frame *residualframe,UBYTE type,bool encoding)
@@ -1721,6 +1750,19 @@ class DCT *Tables::BuildDCT(class Component *comp,UBYTE count,UBYTE precision) c
     JPG_THROW(INVALID_PARAMETER,"Tables::BuildDCT","unsupported DCT requested");
   } else {
     dct->DefineQuant(quant); // does not throw
+    //
+    // The rate-distortion optimizing quantizer estimates the rate from
+    // the default Huffman tables, which are also the starting point for
+    // the optimized tables.
+    if (m_usOptimizeQuant && !lossless) {
+      class HuffmanTemplate t(m_pEnviron);
+      if (comp->IndexOf() > 0 && hasSeparateChroma(count)) {
+        t.InitACChrominanceDefault(Sequential,precision,precision);
+      } else {
+        t.InitACLuminanceDefault(Sequential,precision,precision);
+      }
+      dct->DefineOptimizer(m_usOptimizeQuant,t.EncoderOf());
+    }
   }
 
   return dct;
@@ -177,6 +177,10 @@ class Tables: public JKeeper {
   // Otherwise, the default equi-quantizer is used.
   bool                           m_bDeadZone;
   //
+  // Strength of the rate-distortion optimizing quantizer, or zero
+  // if it is disabled.
+  UWORD                          m_usOptimizeQuant;
+  //
   // This flag is set if an exp marker is found in the tables.
   bool                           m_bFoundExp;
   //
@@ -255,6 +259,10 @@ public:
   // Find the quantization table of the given index.
   const UWORD *FindQuantizationTable(UBYTE idx) const;
   //
+  // Replace all quantization tables by those of the given tables,
+  // for re-encoding quantized data without requantization.
+  void ImportQuantizationTables(const class Tables *source);
+  //
   // Return the residual data if any.
   class DataBox *ResidualDataOf(void) const
   {
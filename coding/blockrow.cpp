@@ -50,7 +50,7 @@ template<class T>
 BlockRow<T>::~BlockRow(void)
 {
   if (m_pBlocks) {
-    m_pEnviron->FreeMem(m_pBlocks,sizeof(struct Block) * m_ulWidth);
+    m_pEnviron->FreeMem(m_pBlocks,sizeof(struct Block) * m_ulWidth,JPGFLAG_MIO_COEFFICIENTS);
   }
 }
 ///
@@ -63,7 +63,8 @@ void BlockRow<T>::AllocateRow(ULONG coefficients)
 {
   if (m_pBlocks == NULL) {
     m_ulWidth = (coefficients + 7) >> 3;
-    m_pBlocks = (struct Block *)m_pEnviron->AllocMem(sizeof(struct Block) * m_ulWidth);
+    m_pBlocks = (struct Block *)m_pEnviron->AllocMem(sizeof(struct Block) * m_ulWidth,
+                                                      JPGFLAG_MIO_COEFFICIENTS);
     memset(m_pBlocks,0,sizeof(struct Block) * m_ulWidth);
   } else {
     assert(m_ulWidth == (coefficients + 7) >> 3);
@@ -71,6 +72,17 @@ void BlockRow<T>::AllocateRow(ULONG coefficients)
 }
 ///
 
+/// BlockRow::ClearRow
+// Reset all blocks of an already allocated row to zero. This is
+// required when an allocated row is recycled for new data.
+template<class T>
+void BlockRow<T>::ClearRow(void)
+{
+  if (m_pBlocks)
+    memset(m_pBlocks,0,sizeof(struct Block) * m_ulWidth);
+}
+///
+
 /// Explicit template instanciation
 template class BlockRow<LONG>;
 template class BlockRow<FLOAT>;
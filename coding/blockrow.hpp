@@ -72,6 +72,10 @@ public:
   // it is still up to the caller to include the subsampling factors.
   void AllocateRow(ULONG coefficients);
   //
+  // Reset all blocks of an already allocated row to zero. This is
+  // required when an allocated row is recycled for new data.
+  void ClearRow(void);
+  //
   // Return the n'th block.
   struct Block *BlockAt(ULONG pos) const
   {
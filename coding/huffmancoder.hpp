@@ -63,7 +63,7 @@ public:
   // Encode the given symbol.
   void Put(BitStream<false> *io,UBYTE symbol) const
   {
-    if (m_ucBits[symbol] == 0) {
+    if (unlikely(m_ucBits[symbol] == 0)) {
       class Environ *m_pEnviron = io->EnvironOf();
       JPG_THROW(INVALID_HUFFMAN,"HuffmanCoder::Put",
                 "Huffman table is unsuitable for selected coding mode - "
@@ -79,8 +79,8 @@ public:
     int i;
 
     for(i = 0;i < 256;i++) {
-      if (m_pucSymbol[i]) m_pEnviron->FreeMem(m_pucSymbol[i],256 * sizeof(UBYTE));      
-      if (m_pucLength[i]) m_pEnviron->FreeMem(m_pucLength[i],256 * sizeof(UBYTE));
+      if (m_pucSymbol[i]) m_pEnviron->FreeMem(m_pucSymbol[i],256 * sizeof(UBYTE),JPGFLAG_MIO_HUFFMAN);      
+      if (m_pucLength[i]) m_pEnviron->FreeMem(m_pucLength[i],256 * sizeof(UBYTE),JPGFLAG_MIO_HUFFMAN);
     }
   }
   //
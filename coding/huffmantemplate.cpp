@@ -53,7 +53,7 @@ HuffmanTemplate::HuffmanTemplate(class Environ *env)
 HuffmanTemplate::~HuffmanTemplate(void)
 {
   if (m_pucValues)
-    m_pEnviron->FreeMem(m_pucValues,sizeof(UBYTE) * m_ulCodewords);
+    m_pEnviron->FreeMem(m_pucValues,sizeof(UBYTE) * m_ulCodewords,JPGFLAG_MIO_HUFFMAN);
   
   delete m_pDecoder;
   delete m_pEncoder;
@@ -106,7 +106,7 @@ UWORD HuffmanTemplate::MarkerOverhead(void) const
 void HuffmanTemplate::ResetEntries(ULONG count)
 { 
   if (m_pucValues) {
-    m_pEnviron->FreeMem(m_pucValues,sizeof(UBYTE) * m_ulCodewords);
+    m_pEnviron->FreeMem(m_pucValues,sizeof(UBYTE) * m_ulCodewords,JPGFLAG_MIO_HUFFMAN);
     m_pucValues = NULL;
   }
 
@@ -116,7 +116,7 @@ void HuffmanTemplate::ResetEntries(ULONG count)
 
   m_ulCodewords = count;
   if (count > 0)
-    m_pucValues = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * m_ulCodewords);
+    m_pucValues = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * m_ulCodewords,JPGFLAG_MIO_HUFFMAN);
 
   memset(m_ucLengths,0,sizeof(m_ucLengths));
 }
@@ -609,10 +609,10 @@ void HuffmanTemplate::BuildDecoder(void)
             code = last;
           } else {
             if (lsbsym[qcode] == NULL) {
-              lsbsym[qcode] = (UBYTE *)m_pEnviron->AllocMem(256 * sizeof(UBYTE));
+              lsbsym[qcode] = (UBYTE *)m_pEnviron->AllocMem(256 * sizeof(UBYTE),JPGFLAG_MIO_HUFFMAN);
             }
             if (lsbsiz[qcode] == NULL) {
-              lsbsiz[qcode] = (UBYTE *)m_pEnviron->AllocMem(256 * sizeof(UBYTE));
+              lsbsiz[qcode] = (UBYTE *)m_pEnviron->AllocMem(256 * sizeof(UBYTE),JPGFLAG_MIO_HUFFMAN);
               memset(lsbsiz[qcode],0xff,256 * sizeof(UBYTE));
             }
             // Codespace must still be unused or already reserved for the extension
@@ -650,7 +650,7 @@ void HuffmanTemplate::ParseMarker(class ByteStream *io)
   
   m_ulCodewords = total;
   assert(m_pucValues == NULL);
-  m_pucValues = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * total);
+  m_pucValues = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * total,JPGFLAG_MIO_HUFFMAN);
 
   for(i = 0;i < total;i++) {
     LONG v = io->Get();
@@ -702,7 +702,7 @@ void HuffmanTemplate::AdjustToStatistics(void)
     // Now update the codeword table. 
     assert(m_pucValues == NULL);
     m_ulCodewords = total;
-    m_pucValues   = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * m_ulCodewords);
+    m_pucValues   = (UBYTE *)m_pEnviron->AllocMem(sizeof(UBYTE) * m_ulCodewords,JPGFLAG_MIO_HUFFMAN);
     //
     // Sort codevalues in. i enumerates the
     // code size in increasing order, j
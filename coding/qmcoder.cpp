@@ -66,6 +66,30 @@ const UWORD QMCoder::Qe_Value[] = {
 };
 ///
 
+/// QMCoder::Qe_Renorm
+// Number of leading zero bits of a byte, i.e. the number of
+// renormalization shifts required for an interval with this byte
+// as its most significant part. Zero has eight.
+const UBYTE QMCoder::Qe_Renorm[] = {
+  8,7,6,6,5,5,5,5,4,4,4,4,4,4,4,4,
+  3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,3,
+  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+  2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,2,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+  0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+};
+///
+
 /// QMCoder::Qe_Switch
 const bool QMCoder::Qe_Switch[] = {
   1,0,0,0,0,0,0,0,
@@ -496,17 +520,27 @@ bool QMCoder::GetSlow(class QMContext &ctxt)
   }
 
   // 
-  // Renormalize.
+  // Renormalize. Shift in as many bits at once as the current
+  // byte provides.
   assert(m_usA);
-  do {
-    if (m_ucCT == 0) {
-      ByteIn();
-      m_ucCT = 8;
-    }
-    m_usA  <<= 1;
-    m_ulC  <<= 1;
-    m_ucCT--;
-  } while((WORD)m_usA > 0);
+  {
+    UBYTE shift = Qe_Renorm[m_usA >> 8];
+    if (shift == 8)
+      shift += Qe_Renorm[m_usA];
+    do {
+      UBYTE bits = shift;
+      if (m_ucCT == 0) {
+        ByteIn();
+        m_ucCT = 8;
+      }
+      if (bits > m_ucCT)
+        bits = m_ucCT;
+      m_usA  <<= bits;
+      m_ulC  <<= bits;
+      m_ucCT  -= bits;
+      shift   -= bits;
+    } while(shift);
+  }
 
   m_usC = m_ulC >> 16;
   
@@ -163,6 +163,9 @@ class QMCoder : public JObject {
   // Next state for LPS coding.
   static const UBYTE Qe_NextLPS[];
   //
+  // Number of renormalization shifts by the upper byte of the interval.
+  static const UBYTE Qe_Renorm[];
+  //
   // Flush the upper bits of the computation register.
   void ByteOut(void);
   //
@@ -97,13 +97,92 @@ void YCbCrTrafo<external,count,oc,trafo,rtrafo>::RGB2YCbCr(const RectAngle<LONG>
 
   {
     const external *rptr,*gptr,*bptr;
+    BYTE rstep,gstep,bstep;
+    LONG rmod,gmod,bmod;
+    //
+    // The output is written through LONG pointers which may alias the
+    // matrices, the DC shift and the LUT pointers of this class. Hence,
+    // load all loop invariants upfront to avoid reloading them for every
+    // pixel.
+    const LONG *elut0 = m_plEncodingLUT[0],*elut1 = NULL,*elut2 = NULL;
+    const LONG outmax = m_lOutMax;
+    const LONG cmax   = ((m_lMax + 1) << COLOR_BITS) - 1;
+    const QUAD dcoff  = QUAD(m_lDCShift) << FIX_BITS;
+    // The L and C matrices.
+    LONG l[9],c[9];
+    //
+    for(x = 0;x < 9;x++) {
+      l[x] = m_lLFwd[x];
+      c[x] = m_lCFwd[x];
+    }
+    //
     switch(count) {
     case 3:
-      bptr = (const external *)(source[2]->ibm_pData);
-      gptr = (const external *)(source[1]->ibm_pData);
+      bptr  = (const external *)(source[2]->ibm_pData);
+      gptr  = (const external *)(source[1]->ibm_pData);
+      bstep = source[2]->ibm_cBytesPerPixel;
+      gstep = source[1]->ibm_cBytesPerPixel;
+      bmod  = source[2]->ibm_lBytesPerRow;
+      gmod  = source[1]->ibm_lBytesPerRow;
+      elut1 = m_plEncodingLUT[1];
+      elut2 = m_plEncodingLUT[2];
     case 1:
-      rptr = (const external *)(source[0]->ibm_pData);
+      rptr  = (const external *)(source[0]->ibm_pData);
+      rstep = source[0]->ibm_cBytesPerPixel;
+      rmod  = source[0]->ibm_lBytesPerRow;
+    }
+    //
+    // For the plain YCbCr transformation, run the transformation in 32 bit
+    // arithmetic if this cannot overflow, which is the case for all
+    // practical matrices. Then, gather the samples of a line first and
+    // transform the line as a whole, which the compiler can vectorize.
+    if (count == 3 && (oc & Extended) == 0 && trafo == MergingSpecBox::YCbCr) {
+      const QUAD maxin = (QUAD(1) << (sizeof(external) << 3)) - 1;
+      const LONG round = (1L << (FIX_BITS - COLOR_BITS)) >> 1;
+      bool narrow      = true;
+      //
+      for(x = 0;x < 9;x += 3) {
+        QUAD bound = (QUAD(l[x] >= 0?l[x]:-l[x]) + QUAD(l[x + 1] >= 0?l[x + 1]:-l[x + 1]) + 
+                      QUAD(l[x + 2] >= 0?l[x + 2]:-l[x + 2])) * maxin + dcoff + round;
+        if (bound > MAX_LONG)
+          narrow = false;
+      }
+      //
+      if (narrow) {
+        const LONG dcl = LONG(dcoff) + round;
+        for(y = ymin;y <= ymax;y++) {
+          LONG *ydst  = target[0] + (y << 3);
+          LONG *cbdst = target[1] + (y << 3);
+          LONG *crdst = target[2] + (y << 3);
+          const external *r = rptr;
+          const external *g = gptr;
+          const external *b = bptr;
+          LONG rv[8],gv[8],bv[8];
+          //
+          for(x = xmin;x <= xmax;x++) {
+            rv[x] = *r;
+            gv[x] = *g;
+            bv[x] = *b;
+            r  = (const external *)((const UBYTE *)(r) + rstep);
+            g  = (const external *)((const UBYTE *)(g) + gstep);
+            b  = (const external *)((const UBYTE *)(b) + bstep);
+          }
+          for(x = xmin;x <= xmax;x++) {
+            LONG yv = (rv[x] * l[0] + gv[x] * l[1] + bv[x] * l[2] + round) >> (FIX_BITS - COLOR_BITS);
+            LONG cb = (rv[x] * l[3] + gv[x] * l[4] + bv[x] * l[5] + dcl)   >> (FIX_BITS - COLOR_BITS);
+            LONG cr = (rv[x] * l[6] + gv[x] * l[7] + bv[x] * l[8] + dcl)   >> (FIX_BITS - COLOR_BITS);
+            ydst[x]  = CLAMP(cmax,yv);
+            cbdst[x] = CLAMP(cmax,cb);
+            crdst[x] = CLAMP(cmax,cr);
+          }
+          bptr  = (const external *)((const UBYTE *)(bptr) + bmod);
+          gptr  = (const external *)((const UBYTE *)(gptr) + gmod);
+          rptr  = (const external *)((const UBYTE *)(rptr) + rmod);
+        }
+        return;
+      }
     }
+    //
     for(y = ymin;y <= ymax;y++) {
       LONG *ydst,*cbdst,*crdst;
       const external *r,*g,*b;
@@ -127,12 +206,12 @@ void YCbCrTrafo<external,count,oc,trafo,rtrafo>::RGB2YCbCr(const RectAngle<LONG>
         case 3:
           // Run the forwards C transformation.
           if (oc & Extended) {
-            rv = FIX_TO_INT(QUAD(*r) * m_lCFwd[0] + QUAD(*g) * m_lCFwd[1] + QUAD(*b) * m_lCFwd[2]);
-            gv = FIX_TO_INT(QUAD(*r) * m_lCFwd[3] + QUAD(*g) * m_lCFwd[4] + QUAD(*b) * m_lCFwd[5]);
-            bv = FIX_TO_INT(QUAD(*r) * m_lCFwd[6] + QUAD(*g) * m_lCFwd[7] + QUAD(*b) * m_lCFwd[8]);
-            rv = APPLY_LUT(m_plEncodingLUT[0],m_lOutMax,rv);
-            gv = APPLY_LUT(m_plEncodingLUT[1],m_lOutMax,gv);
-            bv = APPLY_LUT(m_plEncodingLUT[2],m_lOutMax,bv);
+            rv = FIX_TO_INT(QUAD(*r) * c[0] + QUAD(*g) * c[1] + QUAD(*b) * c[2]);
+            gv = FIX_TO_INT(QUAD(*r) * c[3] + QUAD(*g) * c[4] + QUAD(*b) * c[5]);
+            bv = FIX_TO_INT(QUAD(*r) * c[6] + QUAD(*g) * c[7] + QUAD(*b) * c[8]);
+            rv = APPLY_LUT(elut0,outmax,rv);
+            gv = APPLY_LUT(elut1,outmax,gv);
+            bv = APPLY_LUT(elut2,outmax,bv);
           } else {
             rv = *r;
             gv = *g;
@@ -141,48 +220,46 @@ void YCbCrTrafo<external,count,oc,trafo,rtrafo>::RGB2YCbCr(const RectAngle<LONG>
           switch(trafo) {
           case MergingSpecBox::YCbCr:
             // Offset data such that it is preshifted by COLOR_BITS
-            y  = FIX_TO_COLOR(QUAD(rv) * m_lLFwd[0] + QUAD(gv) * m_lLFwd[1] + QUAD(bv) * m_lLFwd[2]);
-            cb = FIX_TO_COLOR(QUAD(rv) * m_lLFwd[3] + QUAD(gv) * m_lLFwd[4] + QUAD(bv) * m_lLFwd[5] + 
-                              (QUAD(m_lDCShift) << FIX_BITS));
-            cr = FIX_TO_COLOR(QUAD(rv) * m_lLFwd[6] + QUAD(gv) * m_lLFwd[7] + QUAD(bv) * m_lLFwd[8] + 
-                              (QUAD(m_lDCShift) << FIX_BITS));
+            y  = FIX_TO_COLOR(QUAD(rv) * l[0] + QUAD(gv) * l[1] + QUAD(bv) * l[2]);
+            cb = FIX_TO_COLOR(QUAD(rv) * l[3] + QUAD(gv) * l[4] + QUAD(bv) * l[5] + dcoff);
+            cr = FIX_TO_COLOR(QUAD(rv) * l[6] + QUAD(gv) * l[7] + QUAD(bv) * l[8] + dcoff);
             // If this is not the traditional RGB2YCbCr, overflows may happen. This is the encoder,
             // so we can do what we want. Just clamp in this case.
-            *ydst  = CLAMP(((m_lMax + 1) << COLOR_BITS) - 1,y);
-            *cbdst = CLAMP(((m_lMax + 1) << COLOR_BITS) - 1,cb);
-            *crdst = CLAMP(((m_lMax + 1) << COLOR_BITS) - 1,cr);
+            *ydst  = CLAMP(cmax,y);
+            *cbdst = CLAMP(cmax,cb);
+            *crdst = CLAMP(cmax,cr);
             //
-            assert(*ydst  <= ((m_lMax + 1) << COLOR_BITS) - 1);
-            assert(*cbdst <= ((m_lMax + 1) << COLOR_BITS) - 1);
-            assert(*crdst <= ((m_lMax + 1) << COLOR_BITS) - 1);
+            assert(*ydst  <= cmax);
+            assert(*cbdst <= cmax);
+            assert(*crdst <= cmax);
             break;
           case MergingSpecBox::Identity:
             *ydst  = INT_TO_COLOR(rv);
             *cbdst = INT_TO_COLOR(gv);
             *crdst = INT_TO_COLOR(bv);
-            assert(*ydst  <= ((m_lMax + 1) << COLOR_BITS) - 1);
-            assert(*cbdst <= ((m_lMax + 1) << COLOR_BITS) - 1);
-            assert(*crdst <= ((m_lMax + 1) << COLOR_BITS) - 1);
+            assert(*ydst  <= cmax);
+            assert(*cbdst <= cmax);
+            assert(*crdst <= cmax);
             break;
           }
           ydst++,cbdst++,crdst++;
-          r  = (const external *)((const UBYTE *)(r) + source[0]->ibm_cBytesPerPixel);
-          g  = (const external *)((const UBYTE *)(g) + source[1]->ibm_cBytesPerPixel);
-          b  = (const external *)((const UBYTE *)(b) + source[2]->ibm_cBytesPerPixel);
+          r  = (const external *)((const UBYTE *)(r) + rstep);
+          g  = (const external *)((const UBYTE *)(g) + gstep);
+          b  = (const external *)((const UBYTE *)(b) + bstep);
           break;
         case 1: 
-          *ydst = INT_TO_COLOR(m_plEncodingLUT[0][*r]);
+          *ydst = INT_TO_COLOR(elut0[*r]);
           ydst++;
-          r  = (const external *)((const UBYTE *)(r) + source[0]->ibm_cBytesPerPixel);
+          r  = (const external *)((const UBYTE *)(r) + rstep);
           break;
         }
       }
       switch(count) {
       case 3:
-        bptr  = (const external *)((const UBYTE *)(bptr) + source[2]->ibm_lBytesPerRow);
-        gptr  = (const external *)((const UBYTE *)(gptr) + source[1]->ibm_lBytesPerRow);
+        bptr  = (const external *)((const UBYTE *)(bptr) + bmod);
+        gptr  = (const external *)((const UBYTE *)(gptr) + gmod);
       case 1:
-        rptr  = (const external *)((const UBYTE *)(rptr) + source[0]->ibm_lBytesPerRow);
+        rptr  = (const external *)((const UBYTE *)(rptr) + rmod);
       }
     }
   }
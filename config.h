@@ -259,6 +259,7 @@
 #define HAVE_SETJMP_H 1
 #define HAVE_SETJMP 1
 #define HAVE_LONGJMP 1
+#define HAVE__SETJMP 1
 #define HAVE_STDARG_H 1
 #define HAVE_ERRNO_H 1
 #define HAS_PTRDIFF_T 1
@@ -55,14 +55,16 @@
 /// BlockBitmapRequester::BlockBitmapRequester
 BlockBitmapRequester::BlockBitmapRequester(class Frame *frame)
   : BlockBuffer(frame), BitmapCtrl(frame), m_pEnviron(frame->EnvironOf()), m_pFrame(frame),
-    m_pulReadyLines(NULL),
+    m_pulReadyLines(NULL), m_pulDecodedLines(NULL),
     m_ppDownsampler(NULL), m_ppResidualDownsampler(NULL),
     m_ppUpsampler(NULL), m_ppResidualUpsampler(NULL), m_ppOriginalImage(NULL),
     m_ppTempIBM(NULL), m_ppOriginalIBM(NULL),
     m_ppQTemp(NULL), m_ppRTemp(NULL), m_ppDTemp(NULL),
     m_plResidualColorBuffer(NULL), m_plOriginalColorBuffer(NULL),
+    m_plFusedBuffer(NULL), m_ulFusedSize(0),
     m_pppQImage(NULL), m_pppRImage(NULL),
-    m_pResidualHelper(NULL), m_bSubsampling(false), m_bOpenLoop(false)
+    m_pResidualHelper(NULL), m_bSubsampling(false), m_bOpenLoop(false),
+    m_bRecycleRows(false), m_pQAccess(NULL)
 {  
   m_ucCount       = frame->DepthOf(); 
   m_ulPixelWidth  = frame->WidthOf();
@@ -84,6 +86,9 @@ BlockBitmapRequester::~BlockBitmapRequester(void)
   if (m_plOriginalColorBuffer)
     m_pEnviron->FreeMem(m_plOriginalColorBuffer,m_ucCount * 64 * sizeof(LONG));
 
+  if (m_plFusedBuffer)
+    m_pEnviron->FreeMem(m_plFusedBuffer,m_ulFusedSize * sizeof(LONG));
+
   if (m_ppDownsampler) {
     for(i = 0;i < m_ucCount;i++) {
       delete m_ppDownsampler[i];
@@ -136,6 +141,9 @@ BlockBitmapRequester::~BlockBitmapRequester(void)
   if (m_pulReadyLines)
     m_pEnviron->FreeMem(m_pulReadyLines,m_ucCount * sizeof(ULONG));
 
+  if (m_pulDecodedLines)
+    m_pEnviron->FreeMem(m_pulDecodedLines,m_ucCount * sizeof(ULONG));
+
   if (m_pppQImage)
     m_pEnviron->FreeMem(m_pppQImage,m_ucCount * sizeof(class QuantizedRow **));
 
@@ -184,6 +192,11 @@ void BlockBitmapRequester::BuildCommon(void)
     m_pulReadyLines = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * m_ucCount);
     memset(m_pulReadyLines,0,sizeof(ULONG) * m_ucCount);
   }
+
+  if (m_pulDecodedLines == NULL) {
+    m_pulDecodedLines = (ULONG *)m_pEnviron->AllocMem(sizeof(ULONG) * m_ucCount);
+    memset(m_pulDecodedLines,0,sizeof(ULONG) * m_ucCount);
+  }
   
   if (m_pppQImage == NULL) {
     m_pppQImage   = (class QuantizedRow ***)m_pEnviron->AllocMem(sizeof(class QuantizedRow **) * 
@@ -421,6 +434,94 @@ void BlockBitmapRequester::ResetToStartOfImage(void)
 ///
 
 
+/// BlockBitmapRequester::ImportCoefficients
+// Copy the quantized coefficients of all components of the given
+// buffer into this buffer, bypassing the color transformation and the
+// DCT. Both buffers must be built for frames of the same dimensions and
+// subsampling factors. Afterwards, the image is complete for encoding.
+void BlockBitmapRequester::ImportCoefficients(const class BlockBitmapRequester *source)
+{
+  UBYTE i;
+
+  if (source->m_bRecycleRows)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"BlockBitmapRequester::ImportCoefficients",
+              "the coefficients of the source image have been released during decoding");
+
+  if (source->m_ucCount != m_ucCount || source->m_ulPixelWidth != m_ulPixelWidth ||
+      source->m_ulPixelHeight != m_ulPixelHeight)
+    JPG_THROW(INVALID_PARAMETER,"BlockBitmapRequester::ImportCoefficients",
+              "the dimensions of the source image do not match the dimensions of the target");
+
+  for(i = 0;i < m_ucCount;i++) {
+    class Component *comp   = m_pFrame->ComponentOf(i);
+    ULONG height            = (m_ulPixelHeight + comp->SubYOf() - 1) / comp->SubYOf();
+    ULONG rows              = (height + 7) >> 3;
+    const class QuantizedRow *src = source->m_ppQTop[i];
+    //
+    while(rows) {
+      class QuantizedRow *dst = BuildImageRow(m_pppQImage[i],m_pFrame,i);
+      if (src == NULL || src->WidthOf() != dst->WidthOf())
+        JPG_THROW(MALFORMED_STREAM,"BlockBitmapRequester::ImportCoefficients",
+                  "the source image is incomplete, cannot transcode it");
+      memcpy(dst->BlockAt(0),src->BlockAt(0),dst->WidthOf() * sizeof(QuantizedRow::Block));
+      m_pppQImage[i] = &(dst->NextOf());
+      src            = src->NextOf();
+      rows--;
+    }
+    m_pulReadyLines[i] = m_ulPixelHeight;
+  }
+}
+///
+
+/// BlockBitmapRequester::CoefficientRowOf
+// Return the row of quantized coefficients of the given component
+// at the given block row, or NULL if this row has not been decoded
+// completely yet.
+const class QuantizedRow *BlockBitmapRequester::CoefficientRowOf(UBYTE comp,ULONG row)
+{
+  class QuantizedRow *qrow;
+  ULONG y;
+
+  if (comp >= m_ucCount)
+    JPG_THROW(OVERFLOW_PARAMETER,"BlockBitmapRequester::CoefficientRowOf",
+              "requested component does not exist");
+
+  if (m_bRecycleRows)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"BlockBitmapRequester::CoefficientRowOf",
+              "coefficients are released during decoding, cannot access them");
+
+  if (m_ppQTop == NULL || m_pulDecodedLines == NULL)
+    return NULL;
+  //
+  // Rows are allocated before the entropy decoder fills them in, so
+  // their presence alone does not tell whether they are complete.
+  if (row >= (m_pulDecodedLines[comp] + 7) >> 3)
+    return NULL;
+  //
+  // Continue from the last row handed out if possible.
+  if (m_pQAccess && m_ucAccessComp == comp && m_ulAccessRow <= row) {
+    qrow = m_pQAccess;
+    y    = m_ulAccessRow;
+  } else {
+    qrow = m_ppQTop[comp];
+    y    = 0;
+  }
+
+  while(qrow && y < row) {
+    qrow = qrow->NextOf();
+    y++;
+  }
+
+  if (qrow) {
+    m_pQAccess     = qrow;
+    m_ulAccessRow  = row;
+    m_ucAccessComp = comp;
+  }
+
+  return qrow;
+}
+///
+
 /// BlockBitmapRequester::ColorTrafoOf
 // Return the color transformer responsible for this scan.
 class ColorTrafo *BlockBitmapRequester::ColorTrafoOf(bool encoding)
@@ -438,7 +539,11 @@ class QuantizedRow *BlockBitmapRequester::BuildImageRow(class QuantizedRow **qro
     class Component *comp = frame->ComponentOf(i);
     UBYTE subx      = comp->SubXOf();
     ULONG width     = (m_ulPixelWidth  + subx - 1) / subx;
-    *qrow = new(m_pEnviron) class QuantizedRow(m_pEnviron);
+    if (frame == m_pFrame) {
+      *qrow = CreateQuantizedRow(i);
+    } else {
+      *qrow = new(m_pEnviron) class QuantizedRow(m_pEnviron);
+    }
     (*qrow)->AllocateRow(width);
   }
   return *qrow;
@@ -863,6 +968,221 @@ void BlockBitmapRequester::EncodeUnsampled(const RectAngle<LONG> &region,class C
 }
 ///
 
+/// BlockBitmapRequester::isFusable
+// Check whether the fused encoder can handle the subsampling
+// of the frame. This requires that all components are either not
+// subsampled, or subsampled 2x1 or 2x2, and that no residual is
+// coded.
+bool BlockBitmapRequester::isFusable(void) const
+{
+  UBYTE i;
+  
+  // The downsampler buffers the original image for residual coding,
+  // and the height is required to find the last block row.
+  if (m_pResidualHelper || m_ulPixelHeight == 0)
+    return false;
+
+  for(i = 0;i < m_ucCount;i++) {
+    class Component *comp = m_pFrame->ComponentOf(i);
+    UBYTE sx = comp->SubXOf();
+    UBYTE sy = comp->SubYOf();
+
+    if (sx == 1 && sy == 1)
+      continue;
+    if (sx != 2 || sy > 2)
+      return false;
+  }
+
+  return true;
+}
+///
+
+/// BlockBitmapRequester::EncodeFused
+// Encode a region with 2x1 or 2x2 subsampled components, downsample
+// the chroma components directly from the output of the color
+// transformation and run the DCT as soon as a downsampled block
+// row is complete, bypassing the downsampler.
+// The result is identical to that of the downsampler: Samples right
+// of the image are mirrored at the right edge, lines below the image
+// are not part of the mean, and downsampled lines completely below
+// the image are zero.
+void BlockBitmapRequester::EncodeFused(const RectAngle<LONG> &region,class ColorTrafo *ctrafo)
+{
+  ULONG maxval    = (1UL << m_pFrame->HiddenPrecisionOf()) - 1;
+  LONG width      = m_ulPixelWidth;
+  LONG lastx      = (width - 1) >> 3;               // the last block column
+  LONG lasty      = (m_ulPixelHeight - 1) >> 3;     // the last block row
+  LONG edgex      = (lastx > 2)?(lastx - 2):(0);    // first block column in the edge buffer
+  LONG blocks     = (((width + 1) >> 1) + 7) >> 3;  // downsampled blocks per row
+  LONG *rows[4],*edges[4];
+  RectAngle<LONG> r;
+  LONG minx   = region.ra_MinX >> 3;
+  LONG maxx   = region.ra_MaxX >> 3;
+  LONG miny   = region.ra_MinY >> 3;
+  LONG maxy   = region.ra_MaxY >> 3;
+  LONG x,y;
+  UBYTE i;
+  //
+  // Create the buffers on the first call.
+  if (m_plFusedBuffer == NULL) {
+    ULONG size = 0;
+    for(i = 0;i < m_ucCount;i++) {
+      if (m_pFrame->ComponentOf(i)->SubXOf() > 1)
+        size += (blocks << 6) + 8 * 24;
+    }
+    m_plFusedBuffer = (LONG *)m_pEnviron->AllocMem(size * sizeof(LONG));
+    m_ulFusedSize   = size;
+  }
+  //
+  {
+    LONG *buf = m_plFusedBuffer;
+    for(i = 0;i < m_ucCount;i++) {
+      if (m_pFrame->ComponentOf(i)->SubXOf() > 1) {
+        rows[i]  = buf;
+        edges[i] = buf + (blocks << 6);
+        buf     += (blocks << 6) + 8 * 24;
+      } else {
+        rows[i]  = NULL;
+        edges[i] = NULL;
+      }
+    }
+  }
+  //
+  // Loop over the blocks in the available region.
+  for(y = miny,r.ra_MinY = region.ra_MinY;y <= maxy;y++,r.ra_MinY = r.ra_MaxY + 1) {
+    // Number of lines of this block row within the image.
+    LONG lines = m_ulPixelHeight - (y << 3);
+    if (lines > 8)
+      lines = 8;
+    r.ra_MaxY = (r.ra_MinY & -8) + 7;
+    if (r.ra_MaxY > region.ra_MaxY)
+      r.ra_MaxY = region.ra_MaxY;
+    
+    for(x = minx,r.ra_MinX = region.ra_MinX;x <= maxx;x++,r.ra_MinX = r.ra_MaxX + 1) {
+      r.ra_MaxX = (r.ra_MinX & -8) + 7;
+      if (r.ra_MaxX > region.ra_MaxX)
+        r.ra_MaxX = region.ra_MaxX;
+      //
+      // If the user supplied a dedicated LDR image.
+      if (hasLDRImage()) {
+        for(i = 0;i < m_ucCount;i++) {
+          ExtractLDRBitmap(m_ppTempIBM[i],r,i);
+        }
+        ctrafo->LDRRGB2YCbCr(r,m_ppTempIBM,m_ppCTemp); 
+      } else {
+        for(i = 0;i < m_ucCount;i++) {
+          ExtractBitmap(m_ppTempIBM[i],r,i);
+        }
+        ctrafo->RGB2YCbCr(r,m_ppTempIBM,m_ppCTemp);
+      }
+      //
+      for(i = 0;i < m_ucCount;i++) {
+        if (rows[i] == NULL) {
+          class QuantizedRow *qrow = BuildImageRow(m_pppQImage[i],m_pFrame,i);
+          LONG *dst                = qrow->BlockAt(x)->m_Data;
+          m_ppDCT[i]->TransformBlock(m_ppCTemp[i],dst,(maxval + 1) >> 1);
+        } else {
+          UBYTE sy        = m_pFrame->ComponentOf(i)->SubYOf();
+          const LONG *src = m_ppCTemp[i];
+          // This block contributes four columns of the downsampled block,
+          // and for 2x2 subsampling four of its lines.
+          LONG *dst       = rows[i] + ((x >> 1) << 6) + ((x & 1) << 2) + ((sy > 1)?((y & 1) << 5):0);
+          LONG k;
+          //
+          for(k = 0;k < 8;k += sy,src += sy << 3,dst += 8) {
+            LONG n = lines - k; // lines of the image summed up here.
+            if (n >= sy) {
+              if (sy > 1) {
+                dst[0] = (src[0] + src[1] + src[ 8] + src[ 9]) / 4;
+                dst[1] = (src[2] + src[3] + src[10] + src[11]) / 4;
+                dst[2] = (src[4] + src[5] + src[12] + src[13]) / 4;
+                dst[3] = (src[6] + src[7] + src[14] + src[15]) / 4;
+              } else {
+                dst[0] = (src[0] + src[1]) / 2;
+                dst[1] = (src[2] + src[3]) / 2;
+                dst[2] = (src[4] + src[5]) / 2;
+                dst[3] = (src[6] + src[7]) / 2;
+              }
+            } else if (n > 0) {
+              dst[0] = (src[0] + src[1]) / 2;
+              dst[1] = (src[2] + src[3]) / 2;
+              dst[2] = (src[4] + src[5]) / 2;
+              dst[3] = (src[6] + src[7]) / 2;
+            } else {
+              dst[0] = dst[1] = dst[2] = dst[3] = 0;
+            }
+          }
+          //
+          // Keep the full resolution samples at the right edge to mirror
+          // them later.
+          if (x >= edgex) {
+            LONG *edge = edges[i] + ((x - edgex) << 3);
+            for(k = 0;k < 8;k++) {
+              memcpy(edge + k * 24,m_ppCTemp[i] + (k << 3),8 * sizeof(LONG));
+            }
+          }
+        }
+      }
+    }
+    //
+    // Complete the downsampled block row.
+    for(i = 0;i < m_ucCount;i++) {
+      m_pulReadyLines[i] += 8;
+      if (rows[i] == NULL) {
+        class QuantizedRow *qrow = BuildImageRow(m_pppQImage[i],m_pFrame,i);
+        m_pppQImage[i] = &(qrow->NextOf());
+      } else {
+        UBYTE sy = m_pFrame->ComponentOf(i)->SubYOf();
+        LONG top = (sy > 1)?((y & 1) << 2):(0); // first downsampled line of this block row.
+        LONG cx,k;
+        //
+        // Redo the columns that include samples right of the image.
+        // These are mirrored at the right edge.
+        for(cx = width >> 1;cx < (blocks << 3);cx++) {
+          LONG *dst = rows[i] + ((cx >> 3) << 6) + (cx & 7) + (top << 3);
+          LONG p0   = cx << 1;
+          LONG p1   = p0 + 1;
+          if (p0 >= width) p0 = (p0 - width < width)?((width << 1) - 1 - p0):(0);
+          if (p1 >= width) p1 = (p1 - width < width)?((width << 1) - 1 - p1):(0);
+          p0 -= edgex << 3;
+          p1 -= edgex << 3;
+          assert(p0 >= 0 && p0 < 24 && p1 >= 0 && p1 < 24);
+          for(k = 0;k < 8;k += sy,dst += 8) {
+            LONG n = lines - k;
+            const LONG *src = edges[i] + k * 24;
+            if (n >= sy && sy > 1) {
+              *dst = (src[p0] + src[p1] + src[p0 + 24] + src[p1 + 24]) / 4;
+            } else if (n > 0) {
+              *dst = (src[p0] + src[p1]) / 2;
+            } else {
+              *dst = 0;
+            }
+          }
+        }
+        //
+        // Push the blocks into the DCT once the downsampled block row
+        // is complete.
+        if (sy == 1 || (y & 1) || y >= lasty) {
+          class QuantizedRow *qr = BuildImageRow(m_pppQImage[i],m_pFrame,i);
+          LONG bx;
+          if (sy > 1 && (y & 1) == 0) {
+            // The lower half is below the image.
+            for(bx = 0;bx < blocks;bx++) {
+              memset(rows[i] + (bx << 6) + 32,0,32 * sizeof(LONG));
+            }
+          }
+          for(bx = 0;bx < blocks;bx++) {
+            LONG *dst = (qr)?(qr->BlockAt(bx)->m_Data):NULL;
+            m_ppDCT[i]->TransformBlock(rows[i] + (bx << 6),dst,(maxval + 1) >> 1);
+          }
+          m_pppQImage[i] = &(qr->NextOf());
+        }
+      }
+    }
+  }
+}
+///
+
 /// BlockBitmapRequester::CropEncodingRegion
 // First step of a region encoder: Find the region that can be pulled in the next step,
 // from a rectangle request. This potentially shrinks the rectangle, which should be
@@ -911,7 +1231,11 @@ void BlockBitmapRequester::EncodeRegion(const RectAngle<LONG> &region)
 {
   class ColorTrafo *ctrafo = ColorTrafoOf(true);
  
-  if (m_bSubsampling) { 
+  if (m_bSubsampling && isFusable()) {
+    // The common 2x1 and 2x2 subsampling cases without residual:
+    // Downsample directly from the color transformed blocks.
+    EncodeFused(region,ctrafo);
+  } else if (m_bSubsampling) { 
     // Step one: Pull the source data into the input buffers
     // and generate the Q-output (legacy output).
     PullSourceData(region,ctrafo);
@@ -1176,6 +1500,41 @@ void BlockBitmapRequester::ReconstructRegion(const RectAngle<LONG> &region,const
     // direct case, no upsampling required, the easy case.
     ReconstructUnsampled(rr,region,m_ulMaxMCU,ctrafo);
   }
+  //
+  // Release all rows that are no longer required.
+  if (m_bRecycleRows) {
+    assert(m_pResidualHelper == NULL);
+    for(UBYTE i = 0;i < m_ucCount;i++) {
+      RecycleQuantizedRows(i,m_pppQImage[i]);
+    }
+  }
+}
+///
+
+/// BlockBitmapRequester::StartMCUQuantizerRow
+// Start a MCU scan by initializing the quantized rows for this row
+// in this scan. Releases rows no longer required if row recycling
+// is enabled.
+bool BlockBitmapRequester::StartMCUQuantizerRow(class Scan *scan)
+{
+  UBYTE ccnt = scan->ComponentsInScan();
+  //
+  // All lines above the row that is started now have been completed
+  // by the entropy decoder.
+  for(UBYTE i = 0;i < ccnt;i++) {
+    UBYTE idx = scan->ComponentOf(i)->IndexOf();
+    if (m_pulY[idx] > m_pulDecodedLines[idx])
+      m_pulDecodedLines[idx] = m_pulY[idx];
+  }
+
+  if (m_bRecycleRows) {
+    assert(m_pResidualHelper == NULL);
+    for(UBYTE i = 0;i < m_ucCount;i++) {
+      RecycleQuantizedRows(i,m_pppQImage[i]);
+    }
+  }
+
+  return BlockBuffer::StartMCUQuantizerRow(scan);
 }
 ///
 
@@ -1189,7 +1548,8 @@ bool BlockBitmapRequester::isNextMCULineReady(void) const
   for(i = 0;i < m_ucCount;i++) {
     if (m_pulReadyLines[i] < m_ulPixelHeight) { // There is still data to encode
       class Component *comp = m_pFrame->ComponentOf(i);
-      ULONG codedlines      = m_pulCurrentY[i] * comp->SubYOf();
+      // m_pulY is the first line of the MCU row started next.
+      ULONG codedlines      = m_pulY[i] * comp->SubYOf();
       // codedlines + comp->SubYOf() << 3 * comp->MCUHeightOf() is the number of 
       // lines that must be buffered to encode the next MCU
       if (m_pulReadyLines[i] < codedlines + (comp->SubYOf() << 3) * comp->MCUHeightOf())
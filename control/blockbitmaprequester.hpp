@@ -67,6 +67,10 @@ class BlockBitmapRequester : public BlockBuffer, public BitmapCtrl {
   // Number of lines already in the input buffer on encoding.
   ULONG                     *m_pulReadyLines;
   //
+  // Number of lines per component the entropy decoder has completed
+  // in at least one scan, on decoding.
+  ULONG                     *m_pulDecodedLines;
+  //
   // Temporary for decoding how many MCUs are ready on the next
   // iteration.can be pulled next.
   ULONG                      m_ulMaxMCU;
@@ -104,6 +108,15 @@ class BlockBitmapRequester : public BlockBuffer, public BitmapCtrl {
   // The buffer for the original data.
   LONG                      *m_plOriginalColorBuffer;
   //
+  // The buffer of the fused encoder for 2x1 and 2x2 subsampled
+  // components. For each such component, it keeps one row of downsampled
+  // blocks followed by the full resolution samples of the last three
+  // block columns for the extension at the right edge.
+  LONG                      *m_plFusedBuffer;
+  //
+  // Size of the above in LONGs.
+  ULONG                      m_ulFusedSize;
+  //
   // Current position in reconstruction or encoding,
   // going through the color transformation.
   // On decoding, the line in here has the Y-coordinate 
@@ -123,6 +136,19 @@ class BlockBitmapRequester : public BlockBuffer, public BitmapCtrl {
   // use the reconstructed DCT samples.
   bool                       m_bOpenLoop;
   //
+  // True if quantized rows are released as soon as they have
+  // been reconstructed or written. This is only possible if the image
+  // is processed from top to bottom, exactly once, and no later
+  // scan refers to the coefficients again.
+  bool                       m_bRecycleRows;
+  //
+  // The row last handed out by CoefficientRowOf, its component and
+  // its block row, such that rows can be accessed sequentially without
+  // walking the row list from the top each time.
+  class QuantizedRow        *m_pQAccess;
+  ULONG                      m_ulAccessRow;
+  UBYTE                      m_ucAccessComp;
+  //
   // Build common structures for encoding and decoding
   void BuildCommon(void);
   //
@@ -143,6 +169,18 @@ class BlockBitmapRequester : public BlockBuffer, public BitmapCtrl {
   // The encoding procedure without subsampling, which is the much simpler case.
   void EncodeUnsampled(const RectAngle<LONG> &region,class ColorTrafo *ctrafo);
   //
+  // Check whether the fused encoder can handle the subsampling
+  // of the frame. This requires that all components are either not
+  // subsampled, or subsampled 2x1 or 2x2, and that no residual is
+  // coded.
+  bool isFusable(void) const;
+  //
+  // Encode a region with 2x1 or 2x2 subsampled components, downsample
+  // the chroma components directly from the output of the color
+  // transformation and run the DCT as soon as a downsampled block
+  // row is complete, bypassing the downsampler.
+  void EncodeFused(const RectAngle<LONG> &region,class ColorTrafo *ctrafo);
+  //
   // Reconstruct a region not using any subsampling.
   void ReconstructUnsampled(const struct RectangleRequest *rr,const RectAngle<LONG> &region,
                             ULONG maxmcu,class ColorTrafo *ctrafo);
@@ -204,6 +242,11 @@ public:
   // to the encoder.
   virtual bool isNextMCULineReady(void) const;
   //
+  // Start a MCU scan by initializing the quantized rows for this row
+  // in this scan. Releases rows no longer required if row recycling
+  // is enabled.
+  virtual bool StartMCUQuantizerRow(class Scan *scan);
+  //
   // Reset all components on the image side of the control to the
   // start of the image. Required when re-requesting the image
   // for encoding or decoding.
@@ -229,6 +272,26 @@ public:
   // Install a block helper.
   void SetBlockHelper(class ResidualBlockHelper *helper);
   //
+  // Copy the quantized coefficients of all components of the given
+  // buffer into this buffer, bypassing the color transformation and the
+  // DCT. Both buffers must be built for frames of the same dimensions and
+  // subsampling factors. Afterwards, the image is complete for encoding.
+  void ImportCoefficients(const class BlockBitmapRequester *source);
+  //
+  // Return the row of quantized coefficients of the given component
+  // at the given block row, or NULL if this row has not been decoded
+  // completely yet.
+  const class QuantizedRow *CoefficientRowOf(UBYTE comp,ULONG row);
+  //
+  // Release quantized rows once they have been reconstructed or
+  // written, and re-use them for the rows that are coded next. Afterwards,
+  // the image can only be processed once, from top to bottom.
+  void EnableRowRecycling(void)
+  {
+    m_bRecycleRows = true;
+    m_pQAccess     = NULL;
+  }
+  //
   // Post the height of the frame in lines. This happens
   // when the DNL marker is processed.
   virtual void PostImageHeight(ULONG lines)
@@ -54,7 +54,7 @@
 BlockBuffer::BlockBuffer(class Frame *frame)
   : BlockCtrl(frame->EnvironOf()), m_pFrame(frame), m_pulY(NULL), m_pulCurrentY(NULL), 
     m_ppDCT(NULL), m_ppQTop(NULL), m_ppRTop(NULL), 
-    m_pppQStream(NULL), m_pppRStream(NULL)
+    m_pppQStream(NULL), m_pppRStream(NULL), m_ppQFree(NULL)
 {
   m_ucCount       = frame->DepthOf();
   m_ulPixelWidth  = frame->WidthOf();
@@ -101,6 +101,16 @@ BlockBuffer::~BlockBuffer(void)
     m_pEnviron->FreeMem(m_ppRTop,m_ucCount * sizeof(class QuantizedRow *));
   }
 
+  if (m_ppQFree) {
+    for(i = 0;i < m_ucCount;i++) {
+      while((row = m_ppQFree[i])) {
+        m_ppQFree[i] = row->NextOf();
+        delete row;
+      }
+    }
+    m_pEnviron->FreeMem(m_ppQFree,m_ucCount * sizeof(class QuantizedRow *));
+  }
+
   if (m_pppQStream)
     m_pEnviron->FreeMem(m_pppQStream,m_ucCount * sizeof(class QuantizedRow **));
 
@@ -141,6 +151,12 @@ void BlockBuffer::BuildCommon(void)
     memset(m_ppRTop,0,sizeof(class QuantizedRow *) * m_ucCount);
   }
 
+  if (m_ppQFree == NULL) {
+    m_ppQFree     = (class QuantizedRow **)m_pEnviron->AllocMem(sizeof(class QuantizedRow *) * 
+                                                                m_ucCount);
+    memset(m_ppQFree,0,sizeof(class QuantizedRow *) * m_ucCount);
+  }
+
   if (m_pppQStream == NULL) {
     m_pppQStream  = (class QuantizedRow ***)m_pEnviron->AllocMem(sizeof(class QuantizedRow **) * 
                                                                  m_ucCount);
@@ -235,7 +251,7 @@ bool BlockBuffer::StartMCUQuantizerRow(class Scan *scan)
 
       for(y = ymin;y < ymax;y+=8) {
         if (*last == NULL) {
-          *last = new(m_pEnviron) class QuantizedRow(m_pEnviron);
+          *last = CreateQuantizedRow(idx);
         }
         (*last)->AllocateRow(width);
         if (y == ymin)
@@ -252,6 +268,56 @@ bool BlockBuffer::StartMCUQuantizerRow(class Scan *scan)
 }
 ///
 
+/// BlockBuffer::CreateQuantizedRow
+// Return an empty quantized row for the given component. This re-uses
+// a row from the free list if possible, or allocates a new one.
+class QuantizedRow *BlockBuffer::CreateQuantizedRow(UBYTE comp)
+{
+  class QuantizedRow *row = m_ppQFree[comp];
+
+  assert(comp < m_ucCount);
+
+  if (row) {
+    // Re-use a row that has been released before.
+    m_ppQFree[comp] = row->NextOf();
+    row->TagOn(NULL);
+    row->ClearRow();
+    return row;
+  }
+
+  return new(m_pEnviron) class QuantizedRow(m_pEnviron);
+}
+///
+
+/// BlockBuffer::RecycleQuantizedRows
+// Release all quantized rows of the given component from the top of
+// the image buffer up to the row that contains the given link to its
+// successor, and move them into the free list. The row containing
+// the link, and any row still referenced by the stream parser or
+// writer, is kept.
+void BlockBuffer::RecycleQuantizedRows(UBYTE comp,class QuantizedRow **upto)
+{
+  class QuantizedRow **stream = m_pppQStream[comp];
+  class QuantizedRow *row;
+
+  assert(comp < m_ucCount);
+  //
+  // If either position still refers to the top of the buffer, nothing
+  // can be released as the link is part of this object. Neither if
+  // the stream has not yet started.
+  if (stream == NULL || upto == &m_ppQTop[comp] || stream == &m_ppQTop[comp])
+    return;
+
+  while((row = m_ppQTop[comp])) {
+    if (&row->NextOf() == upto || &row->NextOf() == stream)
+      break;
+    m_ppQTop[comp] = row->NextOf();
+    row->TagOn(m_ppQFree[comp]);
+    m_ppQFree[comp] = row;
+  }
+}
+///
+
 /// BlockBuffer::BufferedLines
 // Return the number of lines available for reconstruction from this scan.
 ULONG BlockBuffer::BufferedLines(const struct RectangleRequest *rr) const
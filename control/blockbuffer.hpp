@@ -93,9 +93,24 @@ protected:
   // Current position in stream parsing for the residual.
   class QuantizedRow      ***m_pppRStream;
   //
+  // Quantized rows that have been released after reconstruction and
+  // that are available for re-use, one list per component.
+  class QuantizedRow       **m_ppQFree;
+  //
   // Build common structures for encoding and decoding
   void BuildCommon(void);
   //
+  // Return an empty quantized row for the given component. This re-uses
+  // a row from the free list if possible, or allocates a new one.
+  class QuantizedRow *CreateQuantizedRow(UBYTE comp);
+  //
+  // Release all quantized rows of the given component from the top of
+  // the image buffer up to the row that contains the given link to its
+  // successor, and move them into the free list. The row containing
+  // the link, and any row still referenced by the stream parser or
+  // writer, is kept.
+  void RecycleQuantizedRows(UBYTE comp,class QuantizedRow **upto);
+  //
   //
 public:
   //
@@ -59,7 +59,7 @@ HierarchicalBitmapRequester::HierarchicalBitmapRequester(class Frame *dimensions
     m_ppTempIBM(NULL), m_pSmallestScale(NULL), m_pLargestScale(NULL), m_pTempAdapter(NULL),
     m_pulReadyLines(NULL), m_pulY(NULL), m_pulHeight(NULL),
     m_ppEncodingMCU(NULL), m_ppDecodingMCU(NULL),
-    m_bSubsampling(false)
+    m_bSubsampling(false), m_bRestricted(false)
 #endif
 {
 }
@@ -324,6 +324,53 @@ void HierarchicalBitmapRequester::GenerateDifferentialImage(class Frame *target,
 }
 ///
 
+/// HierarchicalBitmapRequester::RestrictToLargestScale
+// Restrict the reconstructed output to the largest scale added so far.
+// This is used when decoding stops at an intermediate resolution level,
+// the image is then delivered in the dimensions of the largest frame
+// decoded, not in the dimensions of the DHP marker.
+void HierarchicalBitmapRequester::RestrictToLargestScale(void)
+{
+#if ACCUSOFT_CODE
+  class Frame *largest;
+  UBYTE i;
+  
+  assert(m_pLargestScale);
+  largest = m_pLargestScale->FrameOf();
+  //
+  // If the largest scale is already the full image, nothing changes.
+  if (largest->WidthOf() == m_ulPixelWidth && largest->HeightOf() == m_ulPixelHeight)
+    return;
+  //
+  if (largest->HeightOf() == 0)
+    JPG_THROW(MALFORMED_STREAM,"HierarchicalBitmapRequester::RestrictToLargestScale",
+              "height of the resolution level is still undefined, DNL marker missing");
+  //
+  m_ulPixelWidth  = largest->WidthOf();
+  m_ulPixelHeight = largest->HeightOf();
+  m_bRestricted   = true;
+  //
+  // Re-compute the component heights and re-build the upsamplers as these
+  // depend on the image dimensions.
+  for(i = 0;i < m_ucCount;i++) {
+    class Component *comp = m_pFrame->ComponentOf(i);
+    UBYTE subx            = comp->SubXOf();
+    UBYTE suby            = comp->SubYOf();
+    //
+    if (m_pulHeight)
+      m_pulHeight[i]      = (m_ulPixelHeight + suby - 1) / suby;
+    //
+    if (m_ppUpsampler && m_ppUpsampler[i]) {
+      delete m_ppUpsampler[i];
+      m_ppUpsampler[i]    = NULL;
+      m_ppUpsampler[i]    = UpsamplerBase::CreateUpsampler(m_pEnviron,subx,suby,
+                                                           m_ulPixelWidth,m_ulPixelHeight);
+    }
+  }
+#endif
+}
+///
+
 /// HierarchicalBitmapRequester::DefineRegion
 // Define a single 8x8 block starting at the x offset and the given
 // line, taking the input 8x8 buffer.
@@ -500,9 +547,10 @@ void HierarchicalBitmapRequester::RequestUserDataForDecoding(class BitMapHook *b
 #if ACCUSOFT_CODE
   int i;
   
-  if (m_pLargestScale->FrameOf()->WidthOf()   != m_pFrame->WidthOf() ||
-      (m_pLargestScale->FrameOf()->HeightOf() != m_pFrame->HeightOf() &&
-       m_pLargestScale->FrameOf()->HeightOf() != 0 && m_pFrame->HeightOf() != 0)) {
+  if (!m_bRestricted &&
+      (m_pLargestScale->FrameOf()->WidthOf()   != m_pFrame->WidthOf() ||
+       (m_pLargestScale->FrameOf()->HeightOf() != m_pFrame->HeightOf() &&
+        m_pLargestScale->FrameOf()->HeightOf() != 0 && m_pFrame->HeightOf() != 0))) {
     JPG_THROW(MALFORMED_STREAM,"HierarchicalBitmapRequester::ReconstructRegion",
               "hierarchical frame hierarchy is damaged, largest frame does not match the image");
   }
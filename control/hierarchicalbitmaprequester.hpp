@@ -99,6 +99,11 @@ class HierarchicalBitmapRequester : public BitmapCtrl {
   // True if subsampling is required.
   bool                       m_bSubsampling;
   //
+  // True if the output has been restricted to an intermediate
+  // resolution level, i.e. the largest scale is smaller than
+  // the dimensions indicated in the DHP marker.
+  bool                       m_bRestricted;
+  //
   // Build common structures for encoding and decoding
   void BuildCommon(void);
   //
@@ -201,6 +206,12 @@ public:
   // data.
   void GenerateDifferentialImage(class Frame *target,bool &hexp,bool &vexp); 
   //
+  // Restrict the reconstructed output to the largest scale added so far.
+  // This is used when decoding stops at an intermediate resolution level,
+  // the image is then delivered in the dimensions of the largest frame
+  // decoded, not in the dimensions of the DHP marker.
+  void RestrictToLargestScale(void);
+  //
   // Post the height of the frame in lines. This happens
   // when the DNL marker is processed.
   virtual void PostImageHeight(ULONG lines);
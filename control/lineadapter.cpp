@@ -61,7 +61,8 @@ LineAdapter::~LineAdapter(void)
     for(i = 0;i < m_ucCount;i++) {
       while ((line = m_ppFree[i])) {
         m_ppFree[i] = line->m_pNext;
-        if (line->m_pData) m_pEnviron->FreeMem(line->m_pData,m_pulPixelsPerLine[i] * sizeof(LONG));
+        if (line->m_pData) m_pEnviron->FreeMem(line->m_pData,m_pulPixelsPerLine[i] * sizeof(LONG),
+                                               JPGFLAG_MIO_LINES);
         delete line;
       }
     }
@@ -115,7 +116,8 @@ struct Line *LineAdapter::AllocLine(UBYTE comp)
     // allocation throws.
     line->m_pNext  = m_ppFree[comp];
     m_ppFree[comp] = line;
-    line->m_pData     = (LONG *)m_pEnviron->AllocMem(m_pulPixelsPerLine[comp] * sizeof(LONG));
+    line->m_pData     = (LONG *)m_pEnviron->AllocMem(m_pulPixelsPerLine[comp] * sizeof(LONG),
+                                                     JPGFLAG_MIO_LINES);
     m_ppFree[comp] = line->m_pNext;
     line->m_pNext  = NULL;
 #if CHECK_LEVEL > 0
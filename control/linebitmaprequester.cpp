@@ -215,7 +215,7 @@ struct Line *LineBitmapRequester::Start8Lines(UBYTE c)
     int cnt = 8;
     do {
       *target = new(m_pEnviron) struct Line;
-      (*target)->m_pData = (LONG *)m_pEnviron->AllocMem(m_pulWidth[c] * sizeof(LONG));
+      (*target)->m_pData = (LONG *)m_pEnviron->AllocMem(m_pulWidth[c] * sizeof(LONG),JPGFLAG_MIO_LINES);
       target  = &((*target)->m_pNext);
     } while(--cnt);
   }
@@ -80,7 +80,7 @@ LineBuffer::~LineBuffer(void)
       while((row = m_ppTop[i])) {
         m_ppTop[i] = row->m_pNext;
         if (row->m_pData)
-          m_pEnviron->FreeMem(row->m_pData,m_pulWidth[i] * sizeof(LONG));
+          m_pEnviron->FreeMem(row->m_pData,m_pulWidth[i] * sizeof(LONG),JPGFLAG_MIO_LINES);
         delete row;
       }
     }
@@ -209,7 +209,7 @@ bool LineBuffer::StartMCUQuantizerRow(class Scan *scan)
           *last = new(m_pEnviron) struct Line;
         }
         if ((*last)->m_pData == NULL)
-          (*last)->m_pData = (LONG *)m_pEnviron->AllocMem(m_pulWidth[idx] * sizeof(LONG));
+          (*last)->m_pData = (LONG *)m_pEnviron->AllocMem(m_pulWidth[idx] * sizeof(LONG),JPGFLAG_MIO_LINES);
         if (y == ymin)
           m_pppCurrent[idx] = last;
         last = &((*last)->m_pNext);
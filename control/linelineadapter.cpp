@@ -142,7 +142,7 @@ struct Line *LineLineAdapter::AllocateLine(UBYTE comp)
     // Line is not yet there, create it.
     line = new(m_pEnviron) struct Line;
     *m_pppImage[comp] = line;
-    line->m_pData     = (LONG *)m_pEnviron->AllocMem((m_pulWidth[comp] * sizeof(LONG)));
+    line->m_pData     = (LONG *)m_pEnviron->AllocMem((m_pulWidth[comp] * sizeof(LONG)),JPGFLAG_MIO_LINES);
   }
   //
   line = *m_pppImage[comp];
@@ -39,6 +39,7 @@
 
 /// Forwards
 class Quantization;
+class HuffmanCoder;
 struct ImageBitMap;
 ///
 
@@ -63,6 +64,13 @@ public:
   // to the right size.
   virtual void DefineQuant(const UWORD *table) = 0;
   //
+  // Enable the rate-distortion optimizing quantizer of the given
+  // strength, estimating the rate from the code lengths of the
+  // given AC Huffman coder. Must be called after DefineQuant. DCTs
+  // that do not support this ignore the request.
+  virtual void DefineOptimizer(UWORD, const class HuffmanCoder *)
+  { }
+  //
   // Run the DCT on a 8x8 block on the input data, giving the output table.
   virtual void TransformBlock(const LONG *source,LONG *target,LONG dcoffset) = 0;
   //
@@ -37,6 +37,7 @@
 #include "interface/types.hpp"
 #include "std/string.hpp"
 #include "dct/idct.hpp"
+#include "dct/trellis.hpp"
 #include "tools/environment.hpp"
 #include "tools/traits.hpp"
 #include "interface/imagebitmap.hpp"
@@ -64,7 +65,7 @@
 /// IDCT::IDCT
 template<int preshift,typename T,bool deadzone>
 IDCT<preshift,T,deadzone>::IDCT(class Environ *env)
-  : DCT(env)
+  : DCT(env), m_pTrellis(NULL)
 {
 }
 ///
@@ -73,6 +74,7 @@ IDCT<preshift,T,deadzone>::IDCT(class Environ *env)
 template<int preshift,typename T,bool deadzone>
 IDCT<preshift,T,deadzone>::~IDCT(void)
 {
+  delete m_pTrellis;
 }
 ///
 
@@ -86,18 +88,49 @@ void IDCT<preshift,T,deadzone>::DefineQuant(const UWORD *table)
   for(i = 0;i < 64;i++) {
     m_psQuant[i]    = table[i] << preshift;
     m_plInvQuant[i] = LONG(FLOAT(1L << QUANTIZER_BITS) / table[i] + 0.5);
+    //
+    // Use the equi-quantizer if deadzone quantization is turned
+    // off or we are quantizing the DC part, i.e. round to the
+    // nearest, ties away from zero. The deadzone quantizer rounds
+    // at 3/8 for positive and 5/8 for negative values.
+    if (deadzone == false || i == 0) {
+      m_pqRound[i]    = QUAD(1) << (QUANTIZER_SHIFT - 1);
+      m_plPosRound[i] = 1;
+      m_pqNegRound[i] = 0;
+    } else {
+      m_pqRound[i]    = QUAD(3) << (QUANTIZER_SHIFT - 3);
+      m_plPosRound[i] = 0;
+      m_pqNegRound[i] = (QUAD(1) << (QUANTIZER_SHIFT - 2)) - 1;
+    }
   }
 }
 ///
 
+/// IDCT::DefineOptimizer
+// Enable the rate-distortion optimizing quantizer.
+template<int preshift,typename T,bool deadzone>
+void IDCT<preshift,T,deadzone>::DefineOptimizer(UWORD strength,const class HuffmanCoder *ac)
+{
+  UWORD table[64];
+  int i;
+
+  for(i = 0;i < 64;i++)
+    table[i] = UWORD(m_psQuant[i]) >> preshift;
+
+  if (m_pTrellis == NULL)
+    m_pTrellis = new(m_pEnviron) class Trellis(m_pEnviron,strength);
+
+  m_pTrellis->DefineQuant(table);
+  m_pTrellis->DefineRate(ac);
+}
+///
+
 /// IDCT::TransformBlock
 // Run the DCT on a 8x8 block on the input data, giving the output table.
 template<int preshift,typename T,bool deadzone>
 void IDCT<preshift,T,deadzone>::TransformBlock(const LONG *source,LONG *target,LONG dcoffset)
 { 
   LONG *dpend,*dp;
-  const LONG *qp = m_plInvQuant; 
-  bool dc = true;
   //
   // Adjust the DC offset to the number of fractional bits.
   dcoffset <<= preshift + 3 + 3 + INTERMEDIATE_BITS; 
@@ -151,8 +184,8 @@ void IDCT<preshift,T,deadzone>::TransformBlock(const LONG *source,LONG *target,L
     dp[7 << 3]   = FIXED_TO_INTERMEDIATE(ttmp3 + ttmp10 + ttmp13);
   }
   //
-  // Pass over rows and quantize.
-  for(dp = target,dpend = target + (8 << 3);dp < dpend;dp += 8,qp += 8) { 
+  // Pass over rows.
+  for(dp = target,dpend = target + (8 << 3);dp < dpend;dp += 8) { 
     INTER tmp0         = dp[0] + dp[7];
     INTER tmp1         = dp[1] + dp[6];
     INTER tmp2         = dp[2] + dp[5];
@@ -168,14 +201,14 @@ void IDCT<preshift,T,deadzone>::TransformBlock(const LONG *source,LONG *target,L
     tmp3               = dp[3] - dp[4];
 
     // complete DC and middle band.
-    dp[0]              = Quantize((tmp10 + tmp11 - dcoffset) << FIX_BITS,qp[0],dc);
-    dp[4]              = Quantize((tmp10 - tmp11) << FIX_BITS           ,qp[4],false);
+    dp[0]              = (tmp10 + tmp11 - dcoffset) << FIX_BITS;
+    dp[4]              = (tmp10 - tmp11) << FIX_BITS;
     
     INTER_FIXED z1     = (tmp12 + tmp13) * TO_FIX(0.541196100);
 
     // complete bands 2 and 6
-    dp[2]              = Quantize(z1 + tmp12 * TO_FIX(0.765366865),qp[2],false);
-    dp[6]              = Quantize(z1 + tmp13 *-TO_FIX(1.847759065),qp[6],false);
+    dp[2]              = z1 + tmp12 * TO_FIX(0.765366865);
+    dp[6]              = z1 + tmp13 *-TO_FIX(1.847759065);
 
     tmp10              = tmp0 + tmp3;
     tmp11              = tmp1 + tmp2;
@@ -192,12 +225,21 @@ void IDCT<preshift,T,deadzone>::TransformBlock(const LONG *source,LONG *target,L
     INTER_FIXED ttmp12 = tmp12 *-TO_FIX(0.390180644) + z1;
     INTER_FIXED ttmp13 = tmp13 *-TO_FIX(1.961570560) + z1;
 
-    dp[1]              = Quantize(ttmp0 + ttmp10 + ttmp12,qp[1],false);
-    dp[3]              = Quantize(ttmp1 + ttmp11 + ttmp13,qp[3],false);
-    dp[5]              = Quantize(ttmp2 + ttmp11 + ttmp12,qp[5],false);
-    dp[7]              = Quantize(ttmp3 + ttmp10 + ttmp13,qp[7],false);
+    dp[1]              = ttmp0 + ttmp10 + ttmp12;
+    dp[3]              = ttmp1 + ttmp11 + ttmp13;
+    dp[5]              = ttmp2 + ttmp11 + ttmp12;
+    dp[7]              = ttmp3 + ttmp10 + ttmp13;
     dcoffset           = 0;
-    dc                 = false;
+  }
+  //
+  // Quantize the block as a separate stage.
+  if (m_pTrellis) {
+    LONG coef[64];
+    memcpy(coef,target,sizeof(coef));
+    QuantizeBlock(target);
+    m_pTrellis->OptimizeBlock(coef,1.0 / DOUBLE(QUAD(1) << (QUANTIZER_SHIFT - QUANTIZER_BITS)),target);
+  } else {
+    QuantizeBlock(target);
   }
 }
 ///
@@ -209,22 +251,25 @@ void IDCT<preshift,T,deadzone>::InverseTransformBlock(LONG *target,const LONG *s
                                                       LONG dcoffset)
 {
   LONG *dptr,*dend;
-  
-  const WORD *qnt = m_psQuant;
+  LONG dequant[64];
 
   dcoffset <<= preshift + 3;
 
   if (source) {
-    for(dptr = target,dend = target + (8 << 3);dptr < dend;dptr +=8,source += 8,qnt += 8) {
+    //
+    // Dequantize first in a separate stage.
+    DequantizeBlock(dequant,source);
+    source = dequant;
+    for(dptr = target,dend = target + (8 << 3);dptr < dend;dptr +=8,source += 8) {
       // Even part.
-      T  tz2       = source[2] * qnt[2];
-      T  tz3       = source[6] * qnt[6];
+      T  tz2       = source[2];
+      T  tz3       = source[6];
       FIXED z1     = (tz2 + tz3) *  TO_FIX(0.541196100);
       FIXED tmp2   = z1 + tz3    * -TO_FIX(1.847759065);
       FIXED tmp3   = z1 + tz2    *  TO_FIX(0.765366865);
       
-      tz2          = source[0] * qnt[0] + dcoffset;
-      tz3          = source[4] * qnt[4];
+      tz2          = source[0] + dcoffset;
+      tz3          = source[4];
       
       FIXED tmp0   = (tz2 + tz3) << FIX_BITS;
       FIXED tmp1   = (tz2 - tz3) << FIX_BITS;
@@ -234,10 +279,10 @@ void IDCT<preshift,T,deadzone>::InverseTransformBlock(LONG *target,const LONG *s
       FIXED tmp12  = tmp1 - tmp2;
       
       // Odd part.
-      T ttmp0      = source[7] * qnt[7];
-      T ttmp1      = source[5] * qnt[5];
-      T ttmp2      = source[3] * qnt[3];
-      T ttmp3      = source[1] * qnt[1];
+      T ttmp0      = source[7];
+      T ttmp1      = source[5];
+      T ttmp2      = source[3];
+      T ttmp3      = source[1];
       
       T tz1        = ttmp0 + ttmp3;
       tz2          = ttmp1 + ttmp2;
@@ -42,6 +42,7 @@
 
 /// Forwards
 class Quantization;
+class Trellis;
 struct ImageBitMap;
 ///
 
@@ -58,31 +59,48 @@ class IDCT : public DCT {
     // This is because 12+4+3+3+9 = 31
     INTERMEDIATE_BITS = 0,  // fractional bits for representing the intermediate result
     // (none required)
-    QUANTIZER_BITS    = 30  // bits for representing the quantizer
+    QUANTIZER_BITS    = 30, // bits for representing the quantizer
+    QUANTIZER_SHIFT   = FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3
+    // total number of bits removed by the quantizer
   };
   //
   // The (inverse) quantization tables, i.e. multipliers.
   LONG  m_plInvQuant[64];
   //
+  // The rounding offsets for the quantizer: A constant offset, an
+  // offset added for positive and one added for negative inputs.
+  // These implement the equi-quantizer and the deadzone quantizer
+  // by the same operations.
+  QUAD  m_pqRound[64];
+  LONG  m_plPosRound[64];
+  QUAD  m_pqNegRound[64];
+  //
   // The quantizer tables.
   WORD  m_psQuant[64];
   //
-  // Quantize a floating point number with a multiplier, round correctly.
-  // Must remove FIX_BITS + INTER_BITS + 3
-  static inline LONG Quantize(LONG n,LONG qnt,bool dc)
+  // The rate-distortion optimizer, if enabled.
+  class Trellis *m_pTrellis;
+  //
+  // Quantize a block of DCT coefficients in place. The input is in
+  // fixpoint, with FIX_BITS + INTER_BITS + 3 fractional bits.
+  // This runs over all coefficients without branches such that the
+  // compiler can vectorize it.
+  void QuantizeBlock(LONG *block) const
   {
-    // Use the equi-quantizer if deadzone quantization is turned
-    // off or we are quantizing the DC part.
-    if (deadzone == false || dc) {
-      return (n * QUAD(qnt) + (ULONG(-n) >> TypeTrait<LONG>::SignBit) + 
-              (QUAD(1) << (FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3 - 1)))
-        >> (FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3);
-    } else {
-      QUAD m = n >> TypeTrait<LONG>::SignBit;
-      QUAD o = m << (FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3 - 2);
-      return (n * QUAD(qnt) + ((~o) & m) +
-              (QUAD(3) << (FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3 - 3)))
-        >> (FIX_BITS + INTERMEDIATE_BITS + QUANTIZER_BITS + preshift + 3);
+    for(int i = 0;i < 64;i++) {
+      LONG n  = block[i];
+      QUAD m  = n >> TypeTrait<LONG>::SignBit;
+      block[i] = LONG((n * QUAD(m_plInvQuant[i]) + m_pqRound[i] + (m & m_pqNegRound[i]) +
+                       ((ULONG(-n) >> TypeTrait<LONG>::SignBit) & m_plPosRound[i]))
+                      >> QUANTIZER_SHIFT);
+    }
+  }
+  //
+  // Scale the quantized coefficients back to their reconstruction value.
+  void DequantizeBlock(LONG *target,const LONG *source) const
+  {
+    for(int i = 0;i < 64;i++) {
+      target[i] = source[i] * m_psQuant[i];
     }
   }
   //
@@ -96,6 +114,9 @@ public:
   // to the right size.
   virtual void DefineQuant(const UWORD *table);
   //
+  // Enable the rate-distortion optimizing quantizer.
+  virtual void DefineOptimizer(UWORD strength,const class HuffmanCoder *ac);
+  //
   // Run the DCT on a 8x8 block on the input data, giving the output table.
   virtual void TransformBlock(const LONG *source,LONG *target,LONG dcoffset);
   //
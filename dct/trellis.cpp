@@ -0,0 +1,216 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** A rate-distortion optimizing quantizer. It runs on top of the
+** regular quantizer and decides which coefficients of a block to
+** lower in magnitude or to zero out, trading the squared error
+** against the Huffman code lengths of the run/size symbols.
+**
+*/
+
+/// Includes
+#include "interface/types.hpp"
+#include "std/string.hpp"
+#include "dct/dct.hpp"
+#include "dct/trellis.hpp"
+#include "coding/huffmancoder.hpp"
+#include "tools/environment.hpp"
+///
+
+/// Trellis::Trellis
+Trellis::Trellis(class Environ *env,UWORD strength)
+  : JKeeper(env), m_dLambda(strength / 64.0)
+{
+  int i;
+
+  for(i = 0;i < 64;i++) {
+    m_dStep[i]   = 1.0;
+    m_dWeight[i] = 1.0;
+  }
+
+  memset(m_ucLength,0,sizeof(m_ucLength));
+}
+///
+
+/// Trellis::~Trellis
+Trellis::~Trellis(void)
+{
+}
+///
+
+/// Trellis::DefineQuant
+// Install the quantization table in raster order.
+void Trellis::DefineQuant(const UWORD *table)
+{
+  DOUBLE finest = table[1];
+  int i;
+
+  for(i = 1;i < 64;i++) {
+    if (table[i] < finest)
+      finest = table[i];
+  }
+  //
+  // The error is weighted by the squared step size such that the
+  // distortion is that of the reconstructed samples, and not that
+  // of the quantizer indices. Otherwise, the coarsely quantized high
+  // frequencies would be zeroed out far too easily.
+  for(i = 0;i < 64;i++) {
+    m_dStep[i]   = table[i];
+    m_dWeight[i] = (table[i] / finest) * (table[i] / finest);
+  }
+}
+///
+
+/// Trellis::DefineRate
+// Install the code lengths of the AC symbols from the given
+// Huffman coder.
+void Trellis::DefineRate(const class HuffmanCoder *ac)
+{
+  int i;
+
+  for(i = 0;i < 256;i++) {
+    UBYTE len = ac->Length(UBYTE(i));
+    m_ucLength[i] = (len == MAX_UBYTE)?(0):(len);
+  }
+}
+///
+
+/// Trellis::RateOf
+// Return the rate in bits for coding the value v after
+// a run of zeros of the given length. Symbols the table
+// does not contain are charged with the longest possible
+// code length, i.e. they become expensive, but never free.
+DOUBLE Trellis::RateOf(UBYTE run,LONG v) const
+{
+  ULONG a    = (v < 0)?(-v):(v);
+  UBYTE size = 0;
+  UBYTE len;
+  DOUBLE bits = 0.0;
+
+  while(a) {
+    size++;
+    a >>= 1;
+  }
+  //
+  // Runs of sixteen and more zeros are coded by ZRL symbols.
+  while(run >= 16) {
+    len   = m_ucLength[0xf0];
+    bits += (len)?(len):(16);
+    run  -= 16;
+  }
+  
+  len = (size < 16)?(m_ucLength[(run << 4) | size]):(0);
+  if (len == 0)
+    len = 16;
+
+  return bits + len + size;
+}
+///
+
+/// Trellis::OptimizeBlock
+// Optimize a block. The unquantized coefficients come in raster
+// order, and when multiplied by scale, are in the same units as the
+// quantization table. block holds the output of the regular
+// quantizer and is modified in place. The DC coefficient is not
+// touched.
+void Trellis::OptimizeBlock(const LONG *coef,DOUBLE scale,LONG *block) const
+{
+  // All data here is in zig-zag order.
+  DOUBLE x[64];      // the unquantized values in units of the quantizer.
+  DOUBLE zero[64];   // accumulated distortion of zeroing all coefficients up to k.
+  DOUBLE cost[64];   // minimal cost if k is the last nonzero coefficient.
+  LONG   value[64];  // the value selected for k in this case.
+  UBYTE  prev[64];   // the previous nonzero coefficient in this case.
+  DOUBLE best;
+  UBYTE  last;
+  int k,j;
+
+  zero[0]  = 0.0;
+  cost[0]  = 0.0;
+  value[0] = 0;
+  prev[0]  = 0;
+  for(k = 1;k < 64;k++) {
+    int pos = DCT::ScanOrder[k];
+    x[k]    = coef[pos] * scale / m_dStep[pos];
+    zero[k] = zero[k - 1] + x[k] * x[k] * m_dWeight[pos];
+  }
+  //
+  for(k = 1;k < 64;k++) {
+    int  pos = DCT::ScanOrder[k];
+    LONG q   = block[pos];
+    LONG c;
+    //
+    cost[k]  = -1.0;
+    value[k] = 0;
+    prev[k]  = 0;
+    //
+    // Candidates are the quantizer output and the next value
+    // towards zero. Zero itself is covered by skipping k.
+    for(c = 0;c < 2 && q != 0;c++) {
+      DOUBLE e = x[k] - q;
+      DOUBLE d = e * e * m_dWeight[pos];
+      for(j = k - 1;j >= 0;j--) {
+        DOUBLE r,t;
+        if (j > 0 && cost[j] < 0.0)
+          continue;
+        r = RateOf(k - j - 1,q);
+        t = cost[j] + zero[k - 1] - zero[j] + d + m_dLambda * r;
+        if (cost[k] < 0.0 || t < cost[k]) {
+          cost[k]  = t;
+          value[k] = q;
+          prev[k]  = j;
+        }
+      }
+      q += (q > 0)?(-1):(1);
+    }
+  }
+  //
+  // Find the best end of block.
+  best = zero[63];
+  if (m_ucLength[0x00])
+    best += m_dLambda * m_ucLength[0x00];
+  last = 0;
+  for(k = 1;k < 64;k++) {
+    DOUBLE t;
+    if (cost[k] < 0.0)
+      continue;
+    t = cost[k] + zero[63] - zero[k];
+    if (k < 63)
+      t += m_dLambda * m_ucLength[0x00];
+    if (t < best) {
+      best = t;
+      last = k;
+    }
+  }
+  //
+  // Backtrack and install the selected values.
+  for(k = 1;k < 64;k++)
+    block[DCT::ScanOrder[k]] = 0;
+  for(k = last;k > 0;k = prev[k])
+    block[DCT::ScanOrder[k]] = value[k];
+}
+///
@@ -0,0 +1,98 @@
+/*************************************************************************
+
+    This project implements a complete(!) JPEG (10918-1 ITU.T-81) codec,
+    plus a library that can be used to encode and decode JPEG streams. 
+    It also implements ISO/IEC 18477 aka JPEG XT which is an extension
+    towards intermediate, high-dynamic-range lossy and lossless coding
+    of JPEG. In specific, it supports ISO/IEC 18477-3/-6/-7/-8 encoding.
+
+    Copyright (C) 2012-2015 Thomas Richter, University of Stuttgart and
+    Accusoft.
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*************************************************************************/
+/*
+**
+** A rate-distortion optimizing quantizer. It runs on top of the
+** regular quantizer and decides which coefficients of a block to
+** lower in magnitude or to zero out, trading the squared error
+** against the Huffman code lengths of the run/size symbols.
+**
+*/
+
+#ifndef DCT_TRELLIS_HPP
+#define DCT_TRELLIS_HPP
+
+/// Includes
+#include "tools/environment.hpp"
+///
+
+/// Forwards
+class HuffmanCoder;
+///
+
+/// class Trellis
+// A rate-distortion optimizing quantizer. The quantized values are
+// selected by a dynamic program over the zig-zag scan order,
+// minimizing D + lambda * R per block.
+class Trellis : public JKeeper {
+  //
+  // The quantizer step sizes in raster order.
+  DOUBLE m_dStep[64];
+  //
+  // The weights of the squared errors in raster order, the squared
+  // ratio of the step size to the finest AC step size.
+  DOUBLE m_dWeight[64];
+  //
+  // The code lengths of the AC run/size symbols in bits, zero if
+  // the symbol is not available in the table.
+  UBYTE  m_ucLength[256];
+  //
+  // The Lagrangian multiplier. The distortion is measured in units
+  // of the squared finest AC quantizer step size, and thus follows
+  // the squared error of the reconstructed samples.
+  DOUBLE m_dLambda;
+  //
+  // Return the rate in bits for coding the value v after
+  // a run of zeros of the given length. Symbols not in the
+  // table are charged with the longest code length.
+  DOUBLE RateOf(UBYTE run,LONG v) const;
+  //
+public:
+  // Create an optimizer of the given strength. The strength is
+  // the Lagrangian multiplier in units of 1/64th of the squared
+  // finest AC quantizer step size per bit.
+  Trellis(class Environ *env,UWORD strength);
+  //
+  ~Trellis(void);
+  //
+  // Install the quantization table in raster order.
+  void DefineQuant(const UWORD *table);
+  //
+  // Install the code lengths of the AC symbols from the given
+  // Huffman coder.
+  void DefineRate(const class HuffmanCoder *ac);
+  //
+  // Optimize a block. The unquantized coefficients come in raster
+  // order, and when multiplied by scale, are in the same units as the
+  // quantization table. block holds the output of the regular
+  // quantizer and is modified in place. The DC coefficient is not
+  // touched.
+  void OptimizeBlock(const LONG *coef,DOUBLE scale,LONG *block) const;
+};
+///
+
+///
+#endif
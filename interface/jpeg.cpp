@@ -44,10 +44,13 @@
 #include "codestream/rectanglerequest.hpp"
 #include "codestream/encoder.hpp"
 #include "codestream/decoder.hpp"
+#include "codestream/probe.hpp"
 #include "codestream/image.hpp"
 #include "codestream/tables.hpp"
 #include "marker/frame.hpp"
 #include "marker/scan.hpp"
+#include "marker/component.hpp"
+#include "coding/quantizedrow.hpp"
 #include "boxes/mergingspecbox.hpp"
 #include "boxes/checksumbox.hpp"
 #include "tools/checksum.hpp"
@@ -90,6 +93,8 @@ void JPEG::doConstruct(class Environ *env)
   //
   // State variables.
   m_pIOStream        = NULL;
+  m_pProbeStream     = NULL;
+  m_pProbe           = NULL;
   m_pImage           = NULL;
   m_pFrame           = NULL;
   m_pScan            = NULL;
@@ -99,6 +104,9 @@ void JPEG::doConstruct(class Environ *env)
   m_bHeaderWritten   = false;
   m_bOptimized       = false;
   m_bOptimizeHuffman = false;
+  m_bStreaming       = false;
+  m_bStreamRows      = false;
+  m_ulStreamedLines  = 0;
 }
 ///
 
@@ -116,6 +124,12 @@ void JPEG::doDestruct(void)
   delete m_pIOStream;
   m_pIOStream = NULL;
 
+  delete m_pProbe;
+  m_pProbe = NULL;
+
+  delete m_pProbeStream;
+  m_pProbeStream = NULL;
+
   m_pEnviron = NULL; // Deleted elsewhere
 }
 ///
@@ -222,6 +236,36 @@ void JPEG::StopDecoding(void)
 }
 ///
 
+/// JPEG::StreamRegion
+// In streaming mode, reconstruct all lines that are available
+// and have not yet been delivered to the bitmap hook.
+void JPEG::StreamRegion(struct JPG_TagItem *tags)
+{
+  class BitMapHook bmh(tags);
+  struct RectangleRequest rr;
+  ULONG lines;
+  
+  rr.ParseTags(tags,m_pImage);
+  //
+  // Lines are always delivered from top to bottom, in stripes
+  // of eight lines, as the image is released from the top.
+  lines = m_pImage->BufferedLines(&rr);
+  if (lines > ULONG(rr.rr_Request.ra_MaxY) + 1)
+    lines = rr.rr_Request.ra_MaxY + 1;
+  
+  while(m_ulStreamedLines < lines) {
+    struct RectangleRequest stripe = rr;
+    ULONG last = (m_ulStreamedLines | 7) + 1;
+    if (last > lines)
+      last = lines;
+    stripe.rr_Request.ra_MinY = m_ulStreamedLines;
+    stripe.rr_Request.ra_MaxY = last - 1;
+    m_pImage->ReconstructRegion(&bmh,&stripe);
+    m_ulStreamedLines = last;
+  }
+}
+///
+
 /// JPEG::ReadInternal
 // Read a file. This takes all of the tags, class Decode takes.
 void JPEG::ReadInternal(struct JPG_TagItem *tags)
@@ -238,11 +282,16 @@ void JPEG::ReadInternal(struct JPG_TagItem *tags)
     m_pScan          = NULL;
     m_bRow           = false;
     m_bEncoding      = false;
+    m_bStreamRows    = false;
+    m_ulStreamedLines= 0;
   }
 
   if (!m_bDecoding)
     return;
 
+  m_bStreaming = tags->GetTagData(JPGTAG_DECODER_STREAM_RECONSTRUCTION) && 
+    tags->GetTagPtr(JPGTAG_BIH_HOOK);
+
   if (m_pIOStream == NULL) {
     struct JPG_Hook *iohook = (struct JPG_Hook *)(tags->GetTagPtr(JPGTAG_HOOK_IOHOOK));
     if (iohook == NULL)
@@ -274,6 +323,8 @@ void JPEG::ReadInternal(struct JPG_TagItem *tags)
     if (m_pFrame) {
       if (m_pScan == NULL) {
         m_pScan = m_pFrame->StartParseScan(m_pImage->InputStreamOf(m_pIOStream),m_pImage->ChecksumOf());
+        if (m_pScan && m_bStreaming)
+          m_bStreamRows = m_pImage->EnableRowRecycling(m_pScan);
         if (m_pScan && (stopflags & JPGFLAG_DECODER_STOP_SCAN))
           return;
         if (m_pScan == NULL) {
@@ -282,6 +333,8 @@ void JPEG::ReadInternal(struct JPG_TagItem *tags)
             m_pFrame = NULL;
             if (!m_pImage->ParseTrailer(m_pIOStream)) {
               // Image done, stop decoding, image is now loaded.
+              if (m_bStreaming)
+                StreamRegion(tags);
               StopDecoding();
               return;
             }
@@ -304,6 +357,8 @@ void JPEG::ReadInternal(struct JPG_TagItem *tags)
               m_pFrame = NULL;
               if (!m_pImage->ParseTrailer(m_pIOStream)) {
                 // Image done, stop decoding, image is now loaded.
+                if (m_bStreaming)
+                  StreamRegion(tags);
                 StopDecoding();
                 return;
               }
@@ -317,6 +372,8 @@ void JPEG::ReadInternal(struct JPG_TagItem *tags)
               return;
           } 
           m_bRow = false;
+          if (m_bStreaming && m_bStreamRows)
+            StreamRegion(tags);
         }
       }
     }
@@ -345,6 +402,7 @@ JPG_LONG JPEG::Write(struct JPG_TagItem *tags)
 void JPEG::WriteInternal(struct JPG_TagItem *tags)
 { 
   LONG stopflags = tags->GetTagData(JPGTAG_ENCODER_STOP);
+  bool stream    = tags->GetTagData(JPGTAG_ENCODER_STREAM)?true:false;
 
   if (m_pDecoder)
     JPG_THROW(OBJECT_EXISTS,"JPEG::WriteInternal","decoding in process, cannot start encoding");
@@ -360,6 +418,7 @@ void JPEG::WriteInternal(struct JPG_TagItem *tags)
     m_bDecoding      = false;
     m_bHeaderWritten = false;
     m_bOptimized     = false;
+    m_bStreamRows    = false;
   }
 
   //
@@ -388,6 +447,17 @@ void JPEG::WriteInternal(struct JPG_TagItem *tags)
 
   assert(m_pImage);
 
+  //
+  // Only write what is available in streaming mode. Nothing is available
+  // before the image is complete if the statistics must be measured first.
+  if (stream && m_pImage->isImageComplete() == false) {
+    if (m_bOptimizeHuffman) {
+      m_pIOStream->Flush();
+      return;
+    }
+  } else {
+    stream = false;
+  }
 
   if (!m_bOptimized) {
     if (m_bOptimizeHuffman) {
@@ -418,12 +488,21 @@ void JPEG::WriteInternal(struct JPG_TagItem *tags)
 
     if (m_pScan == NULL) {
       m_pScan = m_pFrame->StartWriteScan(m_pImage->OutputStreamOf(m_pIOStream),m_pImage->ChecksumOf());
+      if (stream)
+        m_bStreamRows = m_pImage->EnableRowRecycling(m_pScan);
       if (stopflags & JPGFLAG_ENCODER_STOP_SCAN)
         return;
     }
     assert(m_pScan);
 
     if (!m_bRow) {
+      //
+      // In streaming mode, only start MCU rows whose image data is
+      // available.
+      if (stream && (m_bStreamRows == false || m_pImage->isNextMCULineReady() == false)) {
+        m_pIOStream->Flush();
+        return;
+      }
       if (m_pScan->StartMCURow()) {
         m_bRow = true;
         if (stopflags & JPGFLAG_ENCODER_STOP_ROW)
@@ -586,6 +665,127 @@ void JPEG::InternalProvideImage(struct JPG_TagItem *tags)
 }
 ///
 
+/// JPEG::TranscodeImage
+// Losslessly transcode the image the source object has decoded completely,
+// i.e. re-encode its quantized DCT coefficients with the frame type, scan
+// pattern and entropy coder selected by the tags, without running the DCT
+// or the color transformation. Afterwards, the image is written by Write.
+JPG_LONG JPEG::TranscodeImage(class JPEG *source,struct JPG_TagItem *tags)
+{
+  volatile JPG_LONG ret = JPG_TRUE;
+
+  JPG_TRY {
+    InternalTranscodeImage(source,tags);
+  } JPG_CATCH {
+    ret = JPG_FALSE;
+  } JPG_ENDTRY;
+
+  return ret;
+}
+///
+
+/// JPEG::InternalTranscodeImage
+// Create an image for encoding from the quantized coefficients of the
+// image decoded by the source - the internal version that generates exceptions.
+void JPEG::InternalTranscodeImage(class JPEG *source,struct JPG_TagItem *tags)
+{
+  class Frame *frame;
+  UBYTE subx[256],suby[256];
+  UBYTE depth,i;
+  LONG frametype;
+  ULONG ltrafo = JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE;
+
+  if (source == NULL || source == this || source->m_pDecoder == NULL || source->m_pImage == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalTranscodeImage",
+              "no decoded source image available that could be transcoded");
+
+  if (source->m_bDecoding)
+    JPG_THROW(OBJECT_EXISTS,"JPEG::InternalTranscodeImage",
+              "the source image is not yet decoded completely, cannot transcode it");
+
+  if (m_bDecoding)
+    JPG_THROW(OBJECT_EXISTS,"JPEG::InternalTranscodeImage","Decoding is active, cannot provide image data");
+
+  if (m_pDecoder) {
+    delete m_pDecoder;m_pDecoder = NULL;
+
+    delete m_pImage;m_pImage = NULL;
+
+    delete m_pIOStream;m_pIOStream = NULL;
+
+    m_pFrame           = NULL;
+    m_pScan            = NULL;
+    m_bRow             = false;
+    m_bDecoding        = false;
+    m_bEncoding        = false;
+    m_bHeaderWritten   = false;
+    m_bOptimized       = false;
+    m_bOptimizeHuffman = false;
+  }
+
+  if (m_pImage)
+    JPG_THROW(OBJECT_EXISTS,"JPEG::InternalTranscodeImage","the image is already initialized");
+
+  frame     = source->m_pImage->FirstFrameOf();
+  frametype = tags->GetTagData(JPGTAG_IMAGE_FRAMETYPE);
+  if (frame == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalTranscodeImage",
+              "no decoded source image available that could be transcoded");
+
+  if (frametype & (JPGFLAG_RESIDUAL_CODING | JPGFLAG_PYRAMIDAL))
+    JPG_THROW(INVALID_PARAMETER,"JPEG::InternalTranscodeImage",
+              "transcoding into hierarchical frames or frames with residual data is not supported");
+
+  depth = frame->DepthOf();
+  for(i = 0;i < depth;i++) {
+    class Component *comp = frame->ComponentOf(i);
+    subx[i] = comp->SubXOf();
+    suby[i] = comp->SubYOf();
+  }
+
+  switch(source->m_pImage->TablesOf()->LTrafoTypeOf(depth)) {
+  case MergingSpecBox::Identity:
+    ltrafo = JPGFLAG_MATRIX_COLORTRANSFORMATION_NONE;
+    break;
+  case MergingSpecBox::YCbCr:
+    ltrafo = JPGFLAG_MATRIX_COLORTRANSFORMATION_YCBCR;
+    break;
+  default:
+    JPG_THROW(NOT_IMPLEMENTED,"JPEG::InternalTranscodeImage",
+              "the color transformation of the source image cannot be transcoded");
+  }
+  {
+    // The layout of the image is defined by the source, the frame type and
+    // the scan pattern by the user. Tags found first take precedence.
+    struct JPG_TagItem ctags[] = {
+      JPG_ValueTag(JPGTAG_IMAGE_WIDTH,source->m_pImage->WidthOf()),
+      JPG_ValueTag(JPGTAG_IMAGE_HEIGHT,source->m_pImage->HeightOf()),
+      JPG_ValueTag(JPGTAG_IMAGE_DEPTH,depth),
+      JPG_ValueTag(JPGTAG_IMAGE_PRECISION,source->m_pImage->PrecisionOf()),
+      JPG_PointerTag(JPGTAG_IMAGE_SUBX,subx),
+      JPG_PointerTag(JPGTAG_IMAGE_SUBY,suby),
+      JPG_ValueTag(JPGTAG_MATRIX_LTRAFO,ltrafo),
+      JPG_ValueTag(JPGTAG_RESIDUAL_FRAMETYPE,JPGFLAG_SEQUENTIAL),
+      JPG_ValueTag(JPGTAG_IMAGE_HIDDEN_DCTBITS,0),
+      JPG_ValueTag(JPGTAG_IMAGE_ERRORBOUND,0),
+      JPG_ValueTag(JPGTAG_IMAGE_LOSSLESSDCT,false),
+      JPG_ValueTag(JPGTAG_IMAGE_RESOLUTIONLEVELS,0),
+      JPG_PointerTag(JPGTAG_ALPHA_TAGLIST,NULL),
+      JPG_Continue(tags)
+    };
+
+    if (m_pEncoder == NULL)
+      m_pEncoder = new(m_pEnviron) class Encoder(m_pEnviron);
+
+    m_bOptimizeHuffman = RequiresTwoPassEncoding(ctags);
+    m_pImage           = m_pEncoder->CreateImage(ctags);
+    m_bEncoding        = true;
+    //
+    m_pImage->ImportCoefficients(source->m_pImage);
+  }
+}
+///
+
 /// JPEG::GetInformation
 // Request information from the JPEG object.
 JPG_LONG JPEG::GetInformation(struct JPG_TagItem *tags)
@@ -602,6 +802,80 @@ JPG_LONG JPEG::GetInformation(struct JPG_TagItem *tags)
 }
 ///
 
+/// JPEG::Probe
+// Scan the header of a codestream up to the first scan and return
+// the image properties without setting up the decoder.
+JPG_LONG JPEG::Probe(struct JPG_TagItem *tags)
+{ 
+  volatile JPG_LONG ret = JPG_TRUE;
+ 
+  JPG_TRY {
+    InternalProbe(tags);
+  } JPG_CATCH {
+    ret = JPG_FALSE;
+  } JPG_ENDTRY;
+
+  return ret;
+}
+///
+
+/// JPEG::GetCoefficients
+// Return the quantized DCT coefficients of a block row of a component
+// and its quantization table, without reconstructing the image.
+JPG_LONG JPEG::GetCoefficients(struct JPG_TagItem *tags)
+{ 
+  volatile JPG_LONG ret = JPG_TRUE;
+ 
+  JPG_TRY {
+    InternalGetCoefficients(tags);
+  } JPG_CATCH {
+    ret = JPG_FALSE;
+  } JPG_ENDTRY;
+
+  return ret;
+}
+///
+
+/// JPEG::InternalGetCoefficients
+// Return the quantized coefficients of a block row - the internal version
+// that creates exceptions.
+void JPEG::InternalGetCoefficients(struct JPG_TagItem *tags)
+{
+  UBYTE comp = tags->GetTagData(JPGTAG_DECODER_COEFFICIENT_COMPONENT);
+  ULONG row  = tags->GetTagData(JPGTAG_DECODER_COEFFICIENT_ROW);
+  const class QuantizedRow *qrow;
+  class Component *component;
+  class Frame *frame;
+  ULONG height;
+  
+  if (m_pDecoder == NULL || m_pImage == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalGetCoefficients",
+              "no image loaded whose coefficients could be returned");
+
+  frame = m_pImage->FirstFrameOf();
+  if (frame == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalGetCoefficients",
+              "the frame header has not yet been read, no coefficients available");
+
+  if (comp >= frame->DepthOf())
+    JPG_THROW(OVERFLOW_PARAMETER,"JPEG::InternalGetCoefficients",
+              "requested component does not exist");
+
+  qrow      = m_pImage->CoefficientRowOf(comp,row);
+  component = frame->ComponentOf(comp);
+  height    = frame->HeightOf();
+  if (height)
+    height  = ((height + component->SubYOf() - 1) / component->SubYOf() + 7) >> 3;
+
+  tags->SetTagPtr(JPGTAG_DECODER_COEFFICIENT_BLOCKS,(qrow)?(qrow->BlockAt(0)->m_Data):NULL);
+  tags->SetTagData(JPGTAG_DECODER_COEFFICIENT_WIDTH,(qrow)?(qrow->WidthOf()):0);
+  tags->SetTagData(JPGTAG_DECODER_COEFFICIENT_ROWS,height);
+  if (tags->FindTagItem(JPGTAG_DECODER_COEFFICIENT_QUANTIZATION))
+    tags->SetTagPtr(JPGTAG_DECODER_COEFFICIENT_QUANTIZATION,
+                    const_cast<UWORD *>(m_pImage->TablesOf()->FindQuantizationTable(component->QuantizerOf())));
+}
+///
+
 /// JPEG::GetOutputInformation
 // Return layout information about floating point and conversion from the specs
 // and insert it into the given tag list.
@@ -639,6 +913,10 @@ void JPEG::InternalGetInformation(struct JPG_TagItem *tags)
   struct JPG_TagItem *alphatag  = tags->FindTagItem(JPGTAG_ALPHA_MODE);
   struct JPG_TagItem *alphalist = tags->FindTagItem(JPGTAG_ALPHA_TAGLIST);
 
+  //
+  // The memory statistics are available even without an image.
+  m_pEnviron->GetInformation(tags);
+
   if (m_pImage == NULL)
     JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalGetInformation","no image loaded to request information from");
 
@@ -692,6 +970,32 @@ void JPEG::InternalGetInformation(struct JPG_TagItem *tags)
 }
 ///
 
+/// JPEG::InternalProbe
+// Scan the header of a codestream up to the first scan and return
+// the image properties - the internal version that creates exceptions.
+void JPEG::InternalProbe(struct JPG_TagItem *tags)
+{
+  struct JPG_Hook *iohook = (struct JPG_Hook *)(tags->GetTagPtr(JPGTAG_HOOK_IOHOOK));
+  
+  if (iohook == NULL)
+    JPG_THROW(OBJECT_DOESNT_EXIST,"JPEG::InternalProbe","no IOHook defined to read the data from");
+  //
+  // Release the leftovers of the last call. These cannot live on the
+  // stack since a throw would skip their destructors. Nothing of the
+  // decoder is built.
+  delete m_pProbe;
+  m_pProbe = NULL;
+  delete m_pProbeStream;
+  m_pProbeStream = NULL;
+  //
+  m_pProbeStream = new(m_pEnviron) class IOStream(m_pEnviron,tags);
+  m_pProbe       = new(m_pEnviron) class Probe(m_pEnviron);
+  //
+  m_pProbe->ParseHeader(m_pProbeStream);
+  m_pProbe->GetInformation(tags);
+}
+///
+
 /// JPEG::LastError
 // Return the last exception - the error code, if present - in
 // the primary result code, a pointer to the error string in the
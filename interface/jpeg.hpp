@@ -79,6 +79,12 @@ class JPEG {
   // Currently active IOHook to read and write data to the filing system.
   class IOStream *m_pIOStream;
   //
+  // The stream and the header scanner of the last Probe call. These are
+  // kept here and not on the stack such that they are released even if
+  // probing throws.
+  class IOStream *m_pProbeStream;
+  class Probe    *m_pProbe;
+  //
   // Currently loaded image, if any.
   class Image  *m_pImage;
   //
@@ -106,6 +112,17 @@ class JPEG {
   // Requires optimization?
   bool          m_bOptimizeHuffman;
   //
+  // Reconstruct the image into the bitmap hook while decoding?
+  bool          m_bStreaming;
+  //
+  // Set if the current frame can be reconstructed row by row
+  // while it is decoded, or written row by row while the image
+  // is provided.
+  bool          m_bStreamRows;
+  //
+  // Number of lines already delivered in streaming mode.
+  JPG_ULONG     m_ulStreamedLines;
+  //
   // The real constructor. We must use this, since we're not using
   // NEW to allocate objects, but MALLOC.
   void doConstruct(class Environ *env);
@@ -128,12 +145,28 @@ class JPEG {
   // version that generates exceptions.
   void InternalProvideImage(struct JPG_TagItem *tags);
   //
+  // Create an image for encoding from the quantized coefficients of the
+  // image decoded by the source - the internal version that generates exceptions.
+  void InternalTranscodeImage(class JPEG *source,struct JPG_TagItem *tags);
+  //
   // Request information from the JPEG object - the internal version that creates exceptions.
   void InternalGetInformation(struct JPG_TagItem *tags);
   //
+  // Return the quantized coefficients of a block row - the internal version
+  // that creates exceptions.
+  void InternalGetCoefficients(struct JPG_TagItem *tags);
+  //
+  // Scan the header of a codestream and return the image properties - the
+  // internal version that creates exceptions.
+  void InternalProbe(struct JPG_TagItem *tags);
+  //
   // Stop decoding, then return. Also tests the checksum if there is one.
   void StopDecoding(void);
   //
+  // In streaming mode, reconstruct all lines that are available
+  // and have not yet been delivered to the bitmap hook.
+  void StreamRegion(struct JPG_TagItem *tags);
+  //
   // Check whether any of the scans is optimized Huffman and thus requires a two-pass
   // go over the data.
   bool RequiresTwoPassEncoding(const struct JPG_TagItem *tags) const;
@@ -162,9 +195,36 @@ public:
   // Forward transform an image, push it into the encoder.
   JPG_LONG ProvideImage(struct JPG_TagItem *);
   //
+  // Losslessly transcode the image the source object has decoded completely,
+  // i.e. re-encode its quantized DCT coefficients with the frame type, scan
+  // pattern and entropy coder selected by the tags, without running the DCT
+  // or the color transformation. Afterwards, the image is written by Write.
+  // This takes the same tags as ProvideImage, except that the image layout
+  // and the quantization tables are taken from the source.
+  JPG_LONG TranscodeImage(class JPEG *source,struct JPG_TagItem *);
+  //
   // Request information from the JPEG object.
   JPG_LONG GetInformation(struct JPG_TagItem *);
   //
+  // Return the quantized DCT coefficients of a block row of a component
+  // and its quantization table, without reconstructing the image. See
+  // the JPGTAG_DECODER_COEFFICIENT tags in parameters.hpp.
+  JPG_LONG GetCoefficients(struct JPG_TagItem *);
+  //
+  // Scan the markers of a codestream from the SOI up to the first SOS
+  // marker and fill in the image properties, without building any decoder
+  // state. This requires the IO hook tags as Read() and fills in the
+  // JPGTAG_IMAGE_WIDTH, _HEIGHT, _DEPTH, _PRECISION, _FRAMETYPE and
+  // _HAS_ALPHA tags and JPGTAG_PROFILE, the latter zero if the stream
+  // carries no JPEG XT file type box. The precision is that of the
+  // legacy codestream. JPGTAG_IMAGE_SUBX and _SUBY, if present, point
+  // to arrays of four bytes receiving the subsampling factors of the first
+  // four components. JPEG XT residual data is indicated by the
+  // JPGFLAG_RESIDUAL_CODING flag in the frame type. The stream is
+  // positioned behind the first SOS marker afterwards, and a following
+  // Read() requires a freshly opened stream.
+  JPG_LONG Probe(struct JPG_TagItem *);
+  //
   // Return the last exception - the error code, if present - in
   // the primary result code, a pointer to the error string in the
   // argument. If no error happened, return 0. For finer error handling,
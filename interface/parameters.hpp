@@ -210,6 +210,20 @@
 // Use a deadzone quantizer which may improve the R/D performance a bit.
 // It is still JPEG compliant.
 #define JPGTAG_DEADZONE_QUANTIZER        (JPGTAG_IMAGE_BASE + 0x19)
+//
+// Enable a rate-distortion optimizing (trellis) quantizer that zeros
+// out or lowers coefficients whenever the savings in the Huffman code
+// lengths outweigh the additional error. The tag data is the strength
+// of the optimization, i.e. the Lagrangian multiplier in units of 1/64th
+// of the squared finest AC bucket size per bit. Values around 8 balance
+// rate and distortion. Zero, the default, disables the optimization.
+// It is only available for 8-bit Huffman coding, and ignored otherwise.
+// It is still JPEG compliant.
+#define JPGTAG_OPTIMIZE_QUANTIZER        (JPGTAG_IMAGE_BASE + 0x1a)
+//
+// Only filled in by JPEG::Probe(): A boolean tag that is set to true
+// if the codestream carries a JPEG XT alpha channel.
+#define JPGTAG_IMAGE_HAS_ALPHA           (JPGTAG_IMAGE_BASE + 0x1b)
 
 // Enable or disable the DCT for the residual image. The default
 // is to enable the DCT for all residual scan types but the residual
@@ -892,6 +906,15 @@
 #define JPGFLAG_ACTION_WRITE 'W'  // Write data
 #define JPGFLAG_ACTION_SEEK  'S'  // Skip data
 #define JPGFLAG_ACTION_QUERY 'Q'  // Returns status information on failure
+#define JPGFLAG_ACTION_PREFETCH 'P' // Read-ahead hint, see below
+//
+// If enabled by JPGTAG_HOOK_PREFETCH, the library announces on parsing
+// the marker segments and boxes which bytes it is going to read next.
+// JPGTAG_FIO_OFFSET is then the offset of these bytes relative to the
+// current file position of the hook, JPGTAG_FIO_SIZE their number. The
+// hook may start reading them ahead, but must deliver them on the next
+// read requests as usual, the file position must not change. Returning
+// a negative value disables further hints.
 
 // Userdata for the file hook.
 #define JPGTAG_FIO_USERDATA (JPGTAG_FIO_BASE + 7)
@@ -941,6 +964,12 @@
 // of the above.
 #define JPGTAG_HOOK_BUFFER    (JPGTAG_HOOK_BASE + 0x04)
 
+// If set to true, the library calls the IO hook with the
+// JPGFLAG_ACTION_PREFETCH action whenever it knows the size of
+// the marker segment or box it is about to parse, to allow the
+// hook to read ahead from slow storage. Defaults to false.
+#define JPGTAG_HOOK_PREFETCH  (JPGTAG_HOOK_BASE + 0x05)
+
 // Only for GetInformation(): This tag returns the number of
 // bytes that are still waiting in the input buffer of the
 // library and that haven't been read off so far. This 
@@ -957,12 +986,29 @@
 // This is always the first tag.
 #define JPGTAG_MIO_SIZE (JPGTAG_MEMORY_BASE + 0x01)
 //
-// The type of the memory to be requested. There are
-// currently no types defined.
+// The type of the memory to be requested, one of the
+// JPGFLAG_MIO types below.
 // This is always the second tag on a request, and not
 // available on release.
 #define JPGTAG_MIO_TYPE (JPGTAG_MEMORY_BASE + 0x02)
 //
+// Memory types: These identify the part of the library
+// the memory is requested for. All memory not listed
+// separately, including the objects themselves, is
+// generic memory.
+#define JPGFLAG_MIO_GENERIC      0x00
+// Rows of DCT coefficients
+#define JPGFLAG_MIO_COEFFICIENTS 0x01
+// Lines of image samples, including the
+// up- and downsampling buffers.
+#define JPGFLAG_MIO_LINES        0x02
+// Huffman code tables.
+#define JPGFLAG_MIO_HUFFMAN      0x03
+// JPEG XT boxes and their payload.
+#define JPGFLAG_MIO_BOXES        0x04
+// The number of memory types.
+#define JPGFLAG_MIO_TYPES        0x05
+//
 // The pointer to the memory to be released. This is
 // not available on allocation, but it is always the
 // second tag on release.
@@ -988,6 +1034,29 @@
 // overhead for some allocations.
 #define JPGTAG_MIO_KEEPSIZE     (JPGTAG_MEMORY_BASE + 0x30)
 //
+// A hard limit on the memory a JPEG object may hold at
+// once, in kilobytes (units of 1024 bytes), to be given
+// to JPEG::Construct(). An allocation that would exceed
+// the limit fails with JPGERR_MEMORY_LIMIT before any
+// memory is requested. Zero, the default, disables the
+// limit. GetInformation() also returns the limit.
+#define JPGTAG_MIO_LIMIT        (JPGTAG_MEMORY_BASE + 0x40)
+//
+// Only for GetInformation(): The memory currently held
+// by the JPEG object and the maximum it held so far,
+// both in kilobytes, rounded up. These are filled in
+// even if no image is loaded yet and GetInformation()
+// fails for this reason.
+#define JPGTAG_MIO_CURRENT      (JPGTAG_MEMORY_BASE + 0x41)
+#define JPGTAG_MIO_PEAK         (JPGTAG_MEMORY_BASE + 0x42)
+//
+// Only for GetInformation(): The same, broken up by the
+// memory type t, one of the JPGFLAG_MIO types above.
+// The peaks of the types need not be reached at the
+// same time and hence do not add up to the total peak.
+#define JPGTAG_MIO_CURRENT_TYPE(t) (JPGTAG_MEMORY_BASE + 0x50 + (t))
+#define JPGTAG_MIO_PEAK_TYPE(t)    (JPGTAG_MEMORY_BASE + 0x60 + (t))
+//
 ///
 
 /// Parameters for the decoder
@@ -1015,6 +1084,59 @@
 #define JPGTAG_DECODER_MINCOMPONENT    (JPGTAG_DECODER_BASE + 0x05)
 #define JPGTAG_DECODER_MAXCOMPONENT    (JPGTAG_DECODER_BASE + 0x06)
 //
+// Number of resolution levels of a hierarchical (pyramidal) image
+// to decode, starting at the smallest level. If set to a non-zero
+// value, decoding stops after the indicated number of frames and the
+// image is reconstructed in the dimensions of the largest level
+// decoded, as reported by GetInformation. Zero, the default, decodes
+// all levels. This is ignored for non-hierarchical images.
+#define JPGTAG_DECODER_RESOLUTION_LEVELS (JPGTAG_DECODER_BASE + 0x07)
+//
+// If this tag is set to true and a bitmap hook is passed in the tags
+// of the Read() call, the image is reconstructed into the bitmap hook
+// while it is decoded, in stripes of eight lines from top to bottom,
+// instead of by DisplayRectangle() afterwards. For frames that consist
+// of a single sequential scan containing all components, and that carry
+// no residual, refinement or alpha data, coefficient rows are released
+// as soon as they have been reconstructed, which limits the memory
+// footprint to a few MCU rows. Such images cannot be reconstructed a
+// second time. All other images are delivered through the hook once
+// decoding is complete. The component tags and the horizontal extent
+// of the rectangle in the Read() call select the reconstructed region
+// as for DisplayRectangle().
+#define JPGTAG_DECODER_STREAM_RECONSTRUCTION (JPGTAG_DECODER_BASE + 0x08)
+//
+// The following tags are used by JPEG::GetCoefficients() to access the
+// quantized DCT coefficients of a DCT based, non-hierarchical image
+// directly, without inverse DCT, upsampling or color transformation.
+// Coefficients are available as soon as the entropy decoder completed
+// their block row in a scan, i.e. between Read() calls that stop after
+// MCU rows. In progressive images, rows are only final once the image
+// is decoded completely.
+//
+// The component index, counting from zero, and the block row within
+// this component, i.e. the line in component samples divided by eight.
+#define JPGTAG_DECODER_COEFFICIENT_COMPONENT (JPGTAG_DECODER_BASE + 0x09)
+#define JPGTAG_DECODER_COEFFICIENT_ROW       (JPGTAG_DECODER_BASE + 0x0a)
+//
+// Filled in with a pointer to the coefficients of the requested row,
+// 64 JPG_LONGs per block in natural (row by row, not zig-zag) order, or
+// NULL if the row has not yet been decoded completely. The data belongs to the
+// library and remains valid until the JPEG object is destroyed or the
+// next image is read. It must not be modified.
+#define JPGTAG_DECODER_COEFFICIENT_BLOCKS    (JPGTAG_DECODER_BASE + 0x0b)
+//
+// Filled in with the number of blocks in the requested row.
+#define JPGTAG_DECODER_COEFFICIENT_WIDTH     (JPGTAG_DECODER_BASE + 0x0c)
+//
+// Filled in with the total number of block rows of the component, or
+// zero if the image height is not yet known.
+#define JPGTAG_DECODER_COEFFICIENT_ROWS      (JPGTAG_DECODER_BASE + 0x0d)
+//
+// Filled in with a pointer to the 64 unsigned 16 bit entries of the
+// quantization table of the component, in natural order.
+#define JPGTAG_DECODER_COEFFICIENT_QUANTIZATION (JPGTAG_DECODER_BASE + 0x0e)
+//
 // Parsing flags - these define when the decoder (or encoder) stop, i.e.
 // after which syntax elements the call returns. If it does, the code needs
 // to re-enter the image after reading it until it is complete.
@@ -1062,6 +1184,18 @@
 // Define this to automatically loop in provide image when the image is not
 // yet complete
 #define JPGTAG_ENCODER_LOOP_ON_INCOMPLETE (JPGTAG_ENCODER_BASE + 0x02)
+//
+// If set in Write() while the image is not yet completely provided,
+// write only those parts of the codestream whose image data is
+// available, flush them to the IO hook and return. Call ProvideImage()
+// and Write() alternately until the image is complete; a final Write()
+// then completes the codestream. Data is written incrementally for
+// non-hierarchical baseline or sequential frames that consist of a
+// single scan containing all components, without residual, refinement,
+// alpha or optimized Huffman coding. Coefficient rows are then released
+// as soon as they are written. For all other images, Write() returns
+// without writing scan data until the image is complete.
+#define JPGTAG_ENCODER_STREAM (JPGTAG_ENCODER_BASE + 0x03)
 ///
 
 /// Exception related hooks
@@ -1187,6 +1321,10 @@
 #define JPGERR_OUT_OF_MEMORY       -2048
 // The library run out of memory.
 
+#define JPGERR_MEMORY_LIMIT        -2049
+// The library would have exceeded the memory limit
+// set by JPGTAG_MIO_LIMIT.
+
 
 // Errors below this value (or "above" if you'd look at the absolute value)
 // are user-supplied errors of your hook function. The library
@@ -35,12 +35,60 @@
 #include "io/bitstream.hpp"
 ///
       
+/// BitStream::BulkFill
+// Try to refill the reservoir in one go from the buffered bytes
+// of the byte stream. Returns false if this is not possible because
+// the bytes in reach contain a 0xff, i.e. a stuffed byte or a
+// marker, or the buffer runs dry.
+template<bool bitstuffing>
+bool BitStream<bitstuffing>::BulkFill(void)
+{
+  const UBYTE *buf;
+  UQUAD w,x,mask;
+  UBYTE bytes;
+  //
+  // A pending filler bit requires the byte-wise path.
+  if (bitstuffing && m_ucNextBits != 8)
+    return false;
+  //
+  // Read eight bytes at once, even though fewer may fit. This requires
+  // a sufficiently filled buffer.
+  if (m_pIO->BufferedBytes(buf) < 8)
+    return false;
+  //
+  w = (UQUAD(buf[0]) << 56) | (UQUAD(buf[1]) << 48) | (UQUAD(buf[2]) << 40) | (UQUAD(buf[3]) << 32) |
+      (UQUAD(buf[4]) << 24) | (UQUAD(buf[5]) << 16) | (UQUAD(buf[6]) <<  8) | (UQUAD(buf[7])      );
+  //
+  // Number of complete bytes that fit into the reservoir, and the mask
+  // selecting them in w.
+  bytes = (64 - m_ucBits) >> 3;
+  mask  = ~UQUAD(0) << (64 - (bytes << 3));
+  //
+  // Check whether any of the bytes that go into the reservoir is 0xff.
+  // This is the case if the complement has a zero byte there.
+  x     = ~w;
+  if (((x - UQUAD(0x0101010101010101ULL)) & ~x & UQUAD(0x8080808080808080ULL)) & mask)
+    return false;
+  //
+  m_uqB    |= (w & mask) >> m_ucBits;
+  m_ucBits += bytes << 3;
+  if (m_pChk)
+    m_pChk->Update(buf,bytes);
+  m_pIO->SkipBufferedBytes(bytes);
+  
+  return true;
+}
+///
+
 /// Bitstream::Fill
 // Fill the byte-buffer. Implement bit-stuffing.
 template<bool bitstuffing>
 void BitStream<bitstuffing>::Fill(void)
 {
-  assert(m_ucBits <= 24);
+  assert(m_ucBits <= 56);
+
+  if (likely(BulkFill()))
+    return;
   
   do {
     LONG dt = m_pIO->Get();
@@ -59,7 +107,7 @@ void BitStream<bitstuffing>::Fill(void)
           //
           // ...the next byte has a filler-bit.
           m_ucNextBits = 7;
-          m_ulB       |= ULONG(dt) << (24 - m_ucBits);
+          m_uqB       |= UQUAD(dt) << (56 - m_ucBits);
           m_ucBits    += 8;
         } else {
           m_bMarker    = true;
@@ -75,7 +123,7 @@ void BitStream<bitstuffing>::Fill(void)
             m_pChk->Update(0xff);
             m_pChk->Update(0x00);
           }
-          m_ulB       |= ULONG(dt) << (24 - m_ucBits);
+          m_uqB       |= UQUAD(dt) << (56 - m_ucBits);
           m_ucBits    += 8;
         } else {
           // A marker. Do not advance over the marker, but
@@ -91,15 +139,51 @@ void BitStream<bitstuffing>::Fill(void)
     } else if (bitstuffing) {
       assert(m_ucNextBits == 8 || dt < 128); // was checked before.
       if (m_pChk) m_pChk->Update(dt);
-      m_ulB       |= ULONG(dt) << (32 - m_ucNextBits - m_ucBits);
+      m_uqB       |= UQUAD(dt) << (64 - m_ucNextBits - m_ucBits);
       m_ucBits    += m_ucNextBits;
       m_ucNextBits = 8;
     } else {
       if (m_pChk) m_pChk->Update(dt);
-      m_ulB       |= ULONG(dt) << (24 - m_ucBits);
+      m_uqB       |= UQUAD(dt) << (56 - m_ucBits);
       m_ucBits    += 8;
     }
-  } while(m_ucBits <= 24);
+  } while(m_ucBits <= 56);
+}
+///
+
+/// BitStream::WriteOut
+// Write out all complete bytes of the output accumulator, including
+// byte stuffing. Only used without bitstuffing.
+template<bool bitstuffing>
+void BitStream<bitstuffing>::WriteOut(void)
+{
+  UBYTE buf[16]; // eight bytes, each possibly followed by a stuffed zero.
+  UBYTE bytes = m_ucBits >> 3;
+  UBYTE n     = 0;
+  UBYTE i     = 0;
+
+  assert(!bitstuffing);
+  assert(bytes > 0);
+
+  do {
+    UBYTE b    = UBYTE(m_uqB >> (56 - (i << 3)));
+    buf[n++]   = b;
+    if (b == 0xff)
+      buf[n++] = 0x00; // stuff a zero byte
+  } while(++i < bytes);
+  //
+  // Hand the bytes to the stream and the checksum in one go.
+  m_pIO->Write(buf,n);
+  if (m_pChk)
+    m_pChk->Update(buf,n);
+  //
+  // Keep the remaining bits. Note that shifting by 64 is undefined.
+  if (bytes < 8) {
+    m_uqB  <<= bytes << 3;
+  } else {
+    m_uqB    = 0;
+  }
+  m_ucBits  -= bytes << 3;
 }
 ///
 
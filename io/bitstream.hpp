@@ -47,13 +47,17 @@
 template<bool bitstuffing>
 class BitStream : public JObject {
   //
-  // The bit-buffer for output.
+  // The bit-buffer for output if bitstuffing is enabled.
   UBYTE m_ucB;
   //
-  // The bit-buffer for input.
-  ULONG m_ulB;
+  // The bit-buffer for input. This is a 64 bit reservoir that is
+  // refilled in units of bytes, MSB-aligned. Without bitstuffing,
+  // this is also the accumulator for output.
+  UQUAD m_uqB;
   //
-  // The number of bits left.
+  // The number of bits left. For output with bitstuffing, the number
+  // of free bits in m_ucB, otherwise the number of pending bits in
+  // the accumulator.
   UBYTE m_ucBits;
   //
   // Number of bits the next fill operation fills in.
@@ -75,6 +79,17 @@ class BitStream : public JObject {
   // and detects markers and generates appropriate errors.
   void Fill(void);
   //
+  // Try to refill the reservoir in one go from the buffered bytes
+  // of the byte stream. Returns false if this is not possible because
+  // the bytes in reach contain a 0xff, i.e. a stuffed byte or a
+  // marker, or the buffer runs dry. Fill() then falls back to the
+  // byte-by-byte refill.
+  bool BulkFill(void);
+  //
+  // Write out all complete bytes of the output accumulator, including
+  // byte stuffing. Only used without bitstuffing.
+  void WriteOut(void);
+  //
   // Report an error if not enough bits were available, depending on
   // the error flag.
   void ReportError(void) NORETURN;
@@ -92,7 +107,7 @@ public:
   {
     m_pIO        = io;
     m_pChk       = chk;
-    m_ulB        = 0;
+    m_uqB        = 0;
     m_ucBits     = 0;
     m_ucNextBits = 8;
     m_bMarker    = false;
@@ -104,7 +119,8 @@ public:
     m_pIO        = io;
     m_pChk       = chk;
     m_ucB        = 0;
-    m_ucBits     = 8;
+    m_uqB        = 0;
+    m_ucBits     = (bitstuffing)?(8):(0);
     m_bMarker    = false;
     m_bEOF       = false;
   }
@@ -142,8 +158,8 @@ public:
         ReportError();
     }
     
-    v         = m_ulB >> (32 - n);
-    m_ulB   <<= n;
+    v         = ULONG(m_uqB >> (64 - n));
+    m_uqB   <<= n;
     m_ucBits -= n;
     
     return v;
@@ -163,8 +179,8 @@ public:
         ReportError();
     }
 
-    v         = m_ulB >> (32 - bits);
-    m_ulB   <<= bits;
+    v         = ULONG(m_uqB >> (64 - bits));
+    m_uqB   <<= bits;
     m_ucBits -= bits;
     
     return v;
@@ -178,7 +194,7 @@ public:
     if (m_ucBits < 16)
       Fill();
     
-    return m_ulB >> 16;
+    return UWORD(m_uqB >> 48);
   }
   //
   // Remove n bits without reading them. Prior calls must have ensured
@@ -188,7 +204,7 @@ public:
     if (unlikely(size > m_ucBits))
       ReportError();
 
-    m_ulB   <<= size;
+    m_uqB   <<= size;
     m_ucBits -= size;
   }
   //
@@ -196,15 +212,19 @@ public:
   // coding to ensure that all bits are written out.
   void Flush(void)
   {
-    if (m_ucBits < 8) {
+    if (!bitstuffing) {
+      // Fill up the last byte with 1's, see below.
+      if (m_ucBits & 7)
+        Put(8 - (m_ucBits & 7),0xff);
+      if (m_ucBits)
+        WriteOut();
+    } else if (m_ucBits < 8) {
       // The standard suggests (in an informative note) to fill in
       // remaining bits by 1's, which interestingly creates the likelyhood
       // of a bitstuffing case. Interestingly, the standard also says that
       // a 0xff in front of a marker is a "fill byte" that may be dropped.
       // Conclusion is that we may have a 0xff just in front of a marker without
       // the byte stuffing. Wierd.
-      if (!bitstuffing)
-        m_ucB   |= (1 << m_ucBits) - 1;
       m_pIO->Put(m_ucB);
       if (m_pChk)
         m_pChk->Update(m_ucB);
@@ -245,6 +265,16 @@ public:
   { 
     int n = count;
     assert(n > 0 && n <= 32);
+
+    if (!bitstuffing) {
+      // Collect the bits in the accumulator, and only write
+      // out bytes once it runs full.
+      if (m_ucBits + n > 64)
+        WriteOut();
+      m_ucBits += n;
+      m_uqB    |= (UQUAD(bitbuffer) & ((UQUAD(1) << n) - 1)) << (64 - m_ucBits);
+      return;
+    }
     
     // Do we want to output more bits than
     // there is room in the buffer?
@@ -280,6 +310,16 @@ public:
   void Put(UBYTE n,ULONG bitbuffer)
   {
     assert(n > 0 && n <= 32);
+
+    if (!bitstuffing) {
+      // Collect the bits in the accumulator, and only write
+      // out bytes once it runs full.
+      if (m_ucBits + n > 64)
+        WriteOut();
+      m_ucBits += n;
+      m_uqB    |= (UQUAD(bitbuffer) & ((UQUAD(1) << n) - 1)) << (64 - m_ucBits);
+      return;
+    }
     
     // Do we want to output more bits than
     // there is room in the buffer?
@@ -150,6 +150,14 @@ public:
   // be positive (or zero).
   virtual void SkipBytes(ULONG offset);
   //
+  // Announce that the parser is going to read the given number of
+  // bytes from the current position on. This is only a hint that
+  // allows streams backed by slow storage to read ahead, streams
+  // that cannot make use of it just ignore it.
+  virtual void Prefetch(ULONG)
+  {
+  }
+  //
   //
 #if CHECK_LEVEL > 0
   LONG Get(void);
@@ -228,6 +236,26 @@ public:
     return 0; // shut-up g++
   }
   //
+  // Return the number of bytes that are readily available in the
+  // buffer without requiring a refill, and a pointer to them. This
+  // allows clients to scan ahead over the buffered data in bulk.
+  ULONG BufferedBytes(const UBYTE *&buf) const
+  {
+    buf = m_pucBufPtr;
+    
+    return (m_pucBufPtr)?(ULONG(m_pucBufEnd - m_pucBufPtr)):(0);
+  }
+  //
+  // Advance over bytes that have been obtained by BufferedBytes()
+  // above. The argument must not be larger than the number of bytes
+  // reported there.
+  void SkipBufferedBytes(ULONG n)
+  {
+    assert(m_pucBufPtr + n <= m_pucBufEnd);
+    
+    m_pucBufPtr += n;
+  }
+  //
   // Return the byte counter = #of bytes read or written
   UQUAD FilePosition(void) const
   {
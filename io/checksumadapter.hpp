@@ -78,6 +78,12 @@ public:
   // read stream buffer status. Also to be overloaded.
   virtual LONG Query(void);
   //
+  // Forward a read-ahead hint to the stream that does the real job.
+  virtual void Prefetch(ULONG bytes)
+  {
+    m_pStream->Prefetch(bytes);
+  }
+  //
   // On reading & writing, flush the checksum and prepare to go.
   void Close(void);
   //
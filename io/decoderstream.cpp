@@ -79,6 +79,8 @@ LONG DecoderStream::Fill(void)
       next = m_pCurrent->NextOf();
       //
       if (m_pParent == NULL) {
+        if (m_pCurrent == m_pLast)
+          m_pLast = NULL;
         m_pCurrent->Remove(m_pBufferList);
         delete m_pCurrent;
       }
@@ -126,7 +128,7 @@ bool DecoderStream::Append(class ByteStream *from,ULONG read_size,ULONG index)
     ULONG size;
     struct BufferNode *bn;
     // Now allocate a new buffer node of the given priority and link it in.
-    bn = BufferNode::AddBuffer(m_pEnviron,m_pBufferList,index,read_size);
+    bn = m_pLast = BufferNode::AddBuffer(m_pEnviron,m_pBufferList,m_pLast,index,read_size);
     // And read the data into the buffer.
     size = from->Read(bn->bn_pucBuffer,read_size);
     if (size != read_size) {
@@ -151,8 +153,11 @@ bool DecoderStream::Append(class ByteStream *from,ULONG read_size,ULONG index)
 // sorted it according to the recorded priority.
 void DecoderStream::Append(class DecoderStream *from)
 {  
-  // That's a queue operation.
+  // That's a queue operation. The nodes of the source are no longer
+  // sorted by priority, hence the insertion hints are void.
   BufferNode::AttachQueue(m_pBufferList,from->m_pBufferList);
+  m_pLast       = NULL;
+  from->m_pLast = NULL;
 }
 ///
 
@@ -208,6 +213,8 @@ void DecoderStream::CleanUp(void)
         // this is identically to the behaivour if we would keep this
         // node since the next fill would discard us.
         m_pBufferList = m_pCurrent->NextOf();
+        if (m_pCurrent == m_pLast)
+          m_pLast     = NULL;
         delete m_pCurrent;
         m_pCurrent    = NULL;
       }
@@ -85,8 +85,8 @@ class DecoderStream : public RandomAccessStream {
     ULONG              bn_ulBufSize;    // size of the buffer in bytes
     //
   private:
-    BufferNode(struct BufferNode *&head,ULONG prior,ULONG size)
-      : PriorityQueue<BufferNode>(head,prior), bn_ulBufSize(size)
+    BufferNode(struct BufferNode *&head,struct BufferNode *hint,ULONG prior,ULONG size)
+      : PriorityQueue<BufferNode>(head,hint,prior), bn_ulBufSize(size)
     { 
       // The buffer has been allocated at the end of this structure by the custom allocator.
       bn_pucBuffer = (UBYTE *)(this + 1);
@@ -100,10 +100,12 @@ class DecoderStream : public RandomAccessStream {
     //
   public:
     // Create a new buffer node of the indicated size. The only reason this is here
-    // is because the buffer node cannot be constructed on the stack.
-    static struct BufferNode *AddBuffer(class Environ *env,struct BufferNode *&head,ULONG prior,ULONG size)
+    // is because the buffer node cannot be constructed on the stack. The hint is
+    // a node in the list behind which the search for the insertion point starts.
+    static struct BufferNode *AddBuffer(class Environ *env,struct BufferNode *&head,
+                                        struct BufferNode *hint,ULONG prior,ULONG size)
     {
-      return new(env,size) struct BufferNode(head,prior,size);
+      return new(env,size) struct BufferNode(head,hint,prior,size);
     }
   };
   //
@@ -113,6 +115,10 @@ class DecoderStream : public RandomAccessStream {
   // The current read-out position
   struct BufferNode   *m_pCurrent;
   //
+  // The node appended last. As APP11 markers typically arrive in
+  // order, new nodes are inserted behind this node.
+  struct BufferNode   *m_pLast;
+  //
   // A pointer to the parent stream in case this stream has been "cloned"
   class DecoderStream *m_pParent;
   //
@@ -122,7 +128,7 @@ class DecoderStream : public RandomAccessStream {
 public:
   // Constructor
   DecoderStream(class Environ *env)
-    : RandomAccessStream(env, 0L), m_pBufferList(NULL), m_pCurrent(NULL),
+    : RandomAccessStream(env, 0L), m_pBufferList(NULL), m_pCurrent(NULL), m_pLast(NULL),
       m_pParent(NULL), m_bEOF(false)
   { }
   //
@@ -47,7 +47,8 @@
 // (due to the standard problem of exceptions in constructors).
 IOStream::IOStream(class Environ *env,struct JPG_Hook *in,APTR stream,ULONG bufsize,ULONG userdata,UBYTE *buffer)
   : RandomAccessStream(env, bufsize), m_Hook(*in), m_pHandle(stream),
-    m_ulCachedSeek(0), m_lUserData(userdata), m_pSystemBuffer(NULL), m_pUserBuffer(buffer), m_bSeekable(true)
+    m_ulCachedSeek(0), m_lUserData(userdata), m_pSystemBuffer(NULL), m_pUserBuffer(buffer), m_bSeekable(true),
+    m_bPrefetch(false)
 { 
 }
 ///
@@ -56,7 +57,8 @@ IOStream::IOStream(class Environ *env,struct JPG_Hook *in,APTR stream,ULONG bufs
 // The taglist constructor.
 IOStream::IOStream(class Environ *env,const struct JPG_TagItem *tags)
   : RandomAccessStream(env), m_Hook(&DefaultEntry,this), m_pHandle(NULL),
-    m_ulCachedSeek(0), m_lUserData(0), m_pSystemBuffer(NULL), m_pUserBuffer(NULL), m_bSeekable(true)
+    m_ulCachedSeek(0), m_lUserData(0), m_pSystemBuffer(NULL), m_pUserBuffer(NULL), m_bSeekable(true),
+    m_bPrefetch(false)
 {
   
   while(tags) {
@@ -77,6 +79,9 @@ IOStream::IOStream(class Environ *env,const struct JPG_TagItem *tags)
     case JPGTAG_HOOK_BUFFER:
       m_pUserBuffer = tags->ti_Data.ti_pPtr;
       break;
+    case JPGTAG_HOOK_PREFETCH:
+      m_bPrefetch   = (tags->ti_Data.ti_lData)?true:false;
+      break;
     }
     tags = tags->NextTagItem();
   }
@@ -372,6 +377,34 @@ void IOStream::SkipBytes(ULONG skip)
 }
 ///
 
+/// IOStream::Prefetch
+// Forward a read-ahead hint to the hook if the client asked for it.
+// Only the bytes beyond the buffered data are announced, the offset
+// is relative to the file position of the hook.
+void IOStream::Prefetch(ULONG bytes)
+{
+  ULONG avail = m_pucBufEnd - m_pucBufPtr;
+  //
+  if (m_bPrefetch && bytes > avail) {
+    JPG_TagItem tags[] = {
+      JPG_ValueTag(JPGTAG_FIO_OFFSET,m_ulCachedSeek),
+      JPG_ValueTag(JPGTAG_FIO_SIZE,bytes - avail),
+      JPG_PointerTag(JPGTAG_FIO_HANDLE,m_pHandle),
+      JPG_ValueTag(JPGTAG_FIO_ACTION,JPGFLAG_ACTION_PREFETCH),
+      JPG_ValueTag(JPGTAG_FIO_USERDATA,m_lUserData),
+      JPG_EndTag
+    };
+    //
+    if (m_Hook.CallLong(tags) < 0) {
+      // The hook does not understand hints, do not try again.
+      m_bPrefetch = false;
+    } else {
+      m_lUserData = tags[4].ti_Data.ti_lData;
+    }
+  }
+}
+///
+
 /// IOStream::Query
 // Get the status of the user interface
 LONG IOStream::Query(void)
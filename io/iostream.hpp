@@ -88,6 +88,10 @@ class IOStream : public RandomAccessStream {
   // true in case the stream accepts seeks.
   bool            m_bSeekable;    
   //
+  // true in case the client asked for read-ahead hints and the
+  // hook did not refuse them.
+  bool            m_bPrefetch;
+  //
   // Advance the file position on the underlying hook, truely,
   // Skip bytes by first trying to seek over and then by trying to continuously
   // read over the bytes. Returns false in case seeking did not
@@ -136,6 +140,10 @@ public:
   // buffer.
   virtual void SkipBytes(ULONG skip);
   //
+  // Forward a read-ahead hint to the hook if the client asked for it.
+  // Only the bytes beyond the buffered data are announced.
+  virtual void Prefetch(ULONG bytes);
+  //
   // Set the file pointer to the indicated position (read only!). This may
   // seek within the stream. Note that this implements an absolute 
   // seek relative to the start of the file.
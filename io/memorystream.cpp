@@ -217,7 +217,7 @@ void MemoryStream::Flush(void)
   }
   m_pLast             = node;
   // Get now the buffer itself.
-  buf                 = (UBYTE *)m_pEnviron->AllocMem(m_ulBufSize);
+  buf                 = (UBYTE *)m_pEnviron->AllocMem(m_ulBufSize,JPGFLAG_MIO_BOXES);
   node->bn_pucBuffer  = buf;
   //
   // And make this the new buffer.
@@ -240,7 +240,7 @@ MemoryStream::~MemoryStream(void)
       // the active buffer is part of this list as well
       do {
         next = node->bn_pNext;  // get the next node already 
-        m_pEnviron->FreeMem(node->bn_pucBuffer,m_ulBufSize);
+        m_pEnviron->FreeMem(node->bn_pucBuffer,m_ulBufSize,JPGFLAG_MIO_BOXES);
         delete node;
       } while((node = next));
     }
@@ -368,7 +368,7 @@ void MemoryStream::Clean(void)
       // release the buffer list except for the last node.
       // the active buffer is part of this list as well.
       while((next = node->bn_pNext)) {
-        m_pEnviron->FreeMem(node->bn_pucBuffer,m_ulBufSize);
+        m_pEnviron->FreeMem(node->bn_pucBuffer,m_ulBufSize,JPGFLAG_MIO_BOXES);
         delete node;
         node = next;
       }
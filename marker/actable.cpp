@@ -109,6 +109,8 @@ void ACTable::ParseMarker(class ByteStream *io)
   if (len < 2)
     JPG_THROW(MALFORMED_STREAM,"ACTable::ParseMarker","AC conditioning table length must be at least two bytes long");
 
+  io->Prefetch(len); // the rest of the tables and the next marker.
+
   len -= 2; // remove the marker length.
 
   while(len > 0) {
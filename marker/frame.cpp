@@ -100,6 +100,8 @@ void Frame::ParseMarker(class ByteStream *io)
   if (len < 8)
     JPG_THROW(MALFORMED_STREAM,"Frame::ParseMarker","start of frame marker size invalid");
 
+  io->Prefetch(len); // the rest of the frame header and the next marker.
+
   m_ucPrecision = io->Get();
 
   switch(m_Type) {
@@ -116,6 +116,8 @@ void HuffmanTable::ParseMarker(class ByteStream *io)
   if (len < 2)
     JPG_THROW(MALFORMED_STREAM,"HuffmanTable::ParseMarker","Huffman table length must be at least two bytes long");
 
+  io->Prefetch(len); // the rest of the tables and the next marker.
+
   len -= 2; // remove the marker length.
 
   while(len > 0) {
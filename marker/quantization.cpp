@@ -34,6 +34,7 @@
 #include "marker/quantization.hpp"
 #include "io/bytestream.hpp"
 #include "dct/dct.hpp"
+#include "std/string.hpp"
 ///
 
 /// Pre-defined quantization tables 
@@ -180,6 +181,25 @@ Quantization::~Quantization(void)
 ///
 
 
+/// Quantization::DefineTable
+// Install a table given in raster order at the given index, or
+// remove the table at this index if the table is NULL.
+void Quantization::DefineTable(UBYTE idx,const UWORD *table)
+{
+  if (idx >= 4)
+    JPG_THROW(OVERFLOW_PARAMETER,"Quantization::DefineTable","quantization table index must be between 0 and 3");
+
+  if (table) {
+    if (m_pDelta[idx] == NULL)
+      m_pDelta[idx] = (UWORD *)m_pEnviron->AllocMem(sizeof(UWORD) * 64);
+    memcpy(m_pDelta[idx],table,sizeof(UWORD) * 64);
+  } else if (m_pDelta[idx]) {
+    m_pEnviron->FreeMem(m_pDelta[idx],sizeof(UWORD) * 64);
+    m_pDelta[idx] = NULL;
+  }
+}
+///
+
 /// Quantization::WriteMarker
 // Write the DQT marker to the stream.
 void Quantization::WriteMarker(class ByteStream *io)
@@ -419,6 +439,8 @@ void Quantization::ParseMarker(class ByteStream *io)
   if (len < 2)
     JPG_THROW(MALFORMED_STREAM,"Quantization::ParseMarker","DQT marker must be at least two bytes long");
 
+  io->Prefetch(len); // the rest of the tables and the next marker.
+
   len -= 2; // remove the marker length.
 
   while(len > 2) {
@@ -84,6 +84,10 @@ public:
       return m_pDelta[idx];
     return NULL;
   }
+  //
+  // Install a table given in raster order at the given index, or
+  // remove the table at this index if the table is NULL.
+  void DefineTable(UBYTE idx,const UWORD *table);
 };
 ///
 
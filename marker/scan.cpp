@@ -151,6 +151,8 @@ void Scan::ParseMarker(class ByteStream *io,ScanType type)
   if (len < 8)
     JPG_THROW(MALFORMED_STREAM,"Scan::ParseMarker","marker length of the SOS marker invalid, must be at least 8 bytes long");
 
+  io->Prefetch(len); // the rest of the scan header and the start of the entropy coded data.
+
   data = io->Get();
   if (data < 1 || data > 4)
     JPG_THROW(MALFORMED_STREAM,"Scan::ParseMarker","number of components in scan is invalid, must be between 1 and 4");
@@ -46,4 +46,15 @@
 # endif
 #endif
 
+// The BSD style _setjmp and _longjmp do not save and restore the signal
+// mask, which requires a system call on some platforms on each TRY. The
+// library does not install signal handlers, hence prefer them.
+#if defined(HAVE__SETJMP) && !defined(DEPLOY_PICCLIB)
+# define JPG_SETJMP(jb)    _setjmp(jb)
+# define JPG_LONGJMP(jb,v) _longjmp(jb,v)
+#else
+# define JPG_SETJMP(jb)    setjmp(jb)
+# define JPG_LONGJMP(jb,v) longjmp(jb,v)
+#endif
+
 #endif
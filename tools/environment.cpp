@@ -62,13 +62,7 @@
 /// Externals
 ///
 
-/// Memory counter
-#if CHECK_LEVEL > 0
-static ULONG totalmem    = 0;
-static ULONG maxmem      = 0;
-ULONG malloccount        = 0;
-#endif
-
+/// Memory histogram
 #ifdef HIST
 #include "std/stdio.hpp"
 #define SMALL_MEM_LIMIT 16384
@@ -207,11 +201,33 @@ Environ::Environ(struct JPG_TagItem *tags)
   m_WarningTags[5].ti_Data.ti_pPtr = tags?tags->GetTagPtr(JPGTAG_EXC_WARNING_USERDATA):NULL;
   m_WarningTags[6].ti_Tag    = JPGTAG_TAG_DONE;
   //
+  ResetMemoryStatistics(tags);
   //
   CleanWarnQueue();
 }
 ///
 
+/// Environ::ResetMemoryStatistics
+// Reset the memory statistics and read the limit from the tags.
+void Environ::ResetMemoryStatistics(struct JPG_TagItem *tags)
+{
+  int i;
+  //
+  m_uqCurrentMem = 0;
+  m_uqPeakMem    = 0;
+#if CHECK_LEVEL > 0
+  m_ulAllocCount = 0;
+#endif
+  for(i = 0;i < JPGFLAG_MIO_TYPES;i++) {
+    m_uqTypeMem[i]  = 0;
+    m_uqTypePeak[i] = 0;
+  }
+  //
+  // The limit comes in kilobytes.
+  m_uqMemLimit   = tags?(UQUAD(ULONG(tags->GetTagData(JPGTAG_MIO_LIMIT))) << 10):0;
+}
+///
+
 /// Assignment operator for the environment
 class Environ &Environ::operator=(class Environ &env)
 {
@@ -277,6 +293,21 @@ class Environ &Environ::operator=(class Environ &env)
   m_WarningTags[5].ti_Tag    = JPGTAG_EXC_WARNING_USERDATA;
   m_WarningTags[5]           = env.m_WarningTags[5];
   m_WarningTags[6].ti_Tag    = JPGTAG_TAG_DONE;
+  //
+  // The memory is now owned by this environment, and so are the statistics.
+  {
+    int i;
+    m_uqCurrentMem           = env.m_uqCurrentMem;
+    m_uqPeakMem              = env.m_uqPeakMem;
+    m_uqMemLimit             = env.m_uqMemLimit;
+#if CHECK_LEVEL > 0
+    m_ulAllocCount           = env.m_ulAllocCount;
+#endif
+    for(i = 0;i < JPGFLAG_MIO_TYPES;i++) {
+      m_uqTypeMem[i]         = env.m_uqTypeMem[i];
+      m_uqTypePeak[i]        = env.m_uqTypePeak[i];
+    }
+  }
   
   // Clean the exception root as indicator
   // whether we shall check the memory that remains allocated.
@@ -343,6 +374,10 @@ Environ::Environ(class Environ *env)
   m_WarningTags[5]           = env->m_WarningTags[5];
   m_WarningTags[6].ti_Tag    = JPGTAG_TAG_DONE;
   //
+  // The side-thread keeps its own statistics, but under the same limit.
+  ResetMemoryStatistics(NULL);
+  m_uqMemLimit               = env->m_uqMemLimit;
+  //
   CleanWarnQueue();
   // Setup the pthread identifier
 #ifdef PTHREAD_DEBUGGING
@@ -383,18 +418,15 @@ Environ::~Environ(void)
     //
 #if CHECK_LEVEL > 0
     // Check only on the final destruction.
+    // The statistics are per environment, so other instances of the
+    // library that are still alive do not disturb the check.
     printf("\n%ld bytes memory not yet released.\n"
            "\n%ld bytes maximal required.\n"
            "\n%ld allocations performed.\n",
-           long(totalmem),long(maxmem),long(malloccount));
+           long(m_uqCurrentMem),long(m_uqPeakMem),long(m_ulAllocCount));
 # ifndef USE_VALGRIND
     // All memory released?
-#  if defined(HAVE_ATOMIC_ADDSUB) || defined(USE_I386_XADD) || defined(USE_INTERLOCKED)
-    assert(totalmem == 0);
-#  else
-    printf("\nFinal memory check skipped,\n"
-           "unreliable due to missing locking primitive\n");
-#  endif
+    assert(m_uqCurrentMem == 0);
 # endif
 #endif
   }
@@ -457,7 +489,7 @@ void Environ::Throw(const class Exception &exc)
   */
   //
   // And now jump to the (hopefully collected) catch line.
-  longjmp(es->m_JumpDestination,1);
+  JPG_LONGJMP(es->m_JumpDestination,1);
 }
 //
 ///
@@ -475,7 +507,7 @@ void Environ::ReThrow(void)
   es->Unlink();
   // The error was released to the hook already, hence we need not
   // to forward it again.
-  longjmp(es->m_JumpDestination,1);
+  JPG_LONGJMP(es->m_JumpDestination,1);
 }
 ///
 
@@ -620,7 +652,7 @@ void Environ::NextWarning(void)
 ///
 
 /// Environ::CoreAllocMem
-inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments)
+inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments,UBYTE type)
 {
   // This is only thread-safe only if the user supplied
   // allocation hook is thread-safe. The HIST option is not,
@@ -629,6 +661,14 @@ inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments)
     return NULL;
   } else {
     void *mem;
+    ULONG size = bytesize;
+    //
+    // Refuse the allocation before requesting anything if it
+    // would exceed the limit.
+    if (m_uqMemLimit && m_uqCurrentMem + size > m_uqMemLimit) {
+      class Environ *m_pEnviron = this; // for the macro.
+      JPG_THROW(MEMORY_LIMIT,"Environ::AllocMem","Memory limit exceeded, allocation refused");
+    }
     //
 #if defined(HIST)
     RecordMemAlloc(bytesize);
@@ -647,9 +687,6 @@ inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments)
     } else {
 #ifdef HAVE_MALLOC
       mem = malloc(bytesize);
-#if CHECK_LEVEL > 0
-      malloccount++;
-#endif
 #else
       mem = NULL;
 #endif
@@ -662,10 +699,17 @@ inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments)
       JPG_THROW(OUT_OF_MEMORY,"Environ::AllocMem","Out of free memory, aborted");
     }
     //
+    m_uqCurrentMem    += size;
+    m_uqTypeMem[type] += size;
+    if (m_uqCurrentMem > m_uqPeakMem)
+      m_uqPeakMem = m_uqCurrentMem;
+    if (m_uqTypeMem[type] > m_uqTypePeak[type])
+      m_uqTypePeak[type] = m_uqTypeMem[type];
+#if CHECK_LEVEL > 0
+    m_ulAllocCount++;
+#endif
+    //
 #ifdef MUNGE_MEM
-    totalmem += bytesize; 
-    if (totalmem > maxmem)
-      maxmem = totalmem;
     {
       ULONG  s = bytesize;
       ULONG *p = (ULONG *)mem;
@@ -698,19 +742,23 @@ inline void *Environ::CoreAllocMem(ULONG bytesize,ULONG reqments)
 
 /// Environ::CoreFreeMem
 // Free a memory block
-inline void Environ::CoreFreeMem(void *mem,ULONG bytesize)
+inline void Environ::CoreFreeMem(void *mem,ULONG bytesize,UBYTE type)
 {
   // This is only thread-safe only if the user supplied
   // allocation hook is thread-safe. The HIST option is not,
   // thus don't do that.
   if (mem) {
+    // Released with the type it was allocated with?
+    assert(m_uqTypeMem[type] >= bytesize);
+    m_uqCurrentMem    -= bytesize;
+    m_uqTypeMem[type] -= bytesize;
+    //
 #ifdef MUNGE_MEM
     mem       = (void *)(((Align *)mem)-2);
     bytesize += 2*sizeof(Align);
     //
     // Allocation and release size match?
     assert(bytesize == *(ULONG *)mem);
-    totalmem -= bytesize;
     //
     // Munge memory again
     {
@@ -765,7 +813,7 @@ void *Environ::AllocVec(size_t bytesize,ULONG requirements)
   size_t *mem;
   // This is build directly on AllocMem
   bytesize += sizeof(union Align);
-  mem       = (size_t *)CoreAllocMem(ULONG(bytesize),requirements);
+  mem       = (size_t *)CoreAllocMem(ULONG(bytesize),requirements,JPGFLAG_MIO_GENERIC);
   *mem      = bytesize; // enter the bytesize
   return (void *)(ptrdiff_t(mem) + sizeof(union Align));
 }
@@ -777,7 +825,7 @@ void *Environ::AllocVec(size_t bytesize)
   size_t *mem;
   // This is build directly on AllocMem
   bytesize += sizeof(union Align);
-  mem       = (size_t *)CoreAllocMem(ULONG(bytesize),0);
+  mem       = (size_t *)CoreAllocMem(ULONG(bytesize),0,JPGFLAG_MIO_GENERIC);
   *mem      = bytesize; // enter the bytesize
   return (void *)(ptrdiff_t(mem) + sizeof(union Align)); 
 }
@@ -786,14 +834,15 @@ void *Environ::AllocVec(size_t bytesize)
 /// Environ::AllocMem
 void *Environ::AllocMem(size_t bytesize,ULONG reqments)
 {
-  return CoreAllocMem(ULONG(bytesize),reqments);
+  return CoreAllocMem(ULONG(bytesize),reqments,
+                      UBYTE((reqments < JPGFLAG_MIO_TYPES)?(reqments):(JPGFLAG_MIO_GENERIC)));
 }
 ///
 
 /// Environ::AllocMem without reqments
 void *Environ::AllocMem(size_t bytesize)
 {
-  return CoreAllocMem(ULONG(bytesize),0);
+  return CoreAllocMem(ULONG(bytesize),0,JPGFLAG_MIO_GENERIC);
 }
 ///
 
@@ -802,7 +851,7 @@ void Environ::FreeVec(void *mem)
 {
   if (mem) {
     size_t *sptr = (size_t *)(ptrdiff_t(mem) - sizeof(union Align));
-    CoreFreeMem(sptr,ULONG(*sptr));
+    CoreFreeMem(sptr,ULONG(*sptr),JPGFLAG_MIO_GENERIC);
   }
 }
 ///
@@ -810,7 +859,15 @@ void Environ::FreeVec(void *mem)
 /// Environ::FreeMem
 void Environ::FreeMem(void *mem,size_t bytesize)
 {
-  CoreFreeMem(mem,ULONG(bytesize));
+  CoreFreeMem(mem,ULONG(bytesize),JPGFLAG_MIO_GENERIC);
+}
+///
+
+/// Environ::FreeMem with reqments
+void Environ::FreeMem(void *mem,size_t bytesize,ULONG reqments)
+{
+  CoreFreeMem(mem,ULONG(bytesize),
+              UBYTE((reqments < JPGFLAG_MIO_TYPES)?(reqments):(JPGFLAG_MIO_GENERIC)));
 }
 ///
 
@@ -835,6 +892,20 @@ void Environ::ForwardMessage(struct JPG_Hook *hook,struct JPG_TagItem *tags,
 }
 ///
 
+/// KiloBytesOf
+// Convert a byte count into kilobytes for the tags, rounding up
+// and saturating at the largest value a tag can carry.
+static JPG_LONG KiloBytesOf(UQUAD bytes)
+{
+  UQUAD kb = (bytes + 1023) >> 10;
+
+  if (kb > UQUAD(MAX_LONG))
+    return MAX_LONG;
+
+  return JPG_LONG(kb);
+}
+///
+
 /// Environ::GetInformation
 // Get information about the environment.
 void Environ::GetInformation(struct JPG_TagItem *tags) const
@@ -866,6 +937,29 @@ void Environ::GetInformation(struct JPG_TagItem *tags) const
       curtag->ti_Data.ti_pPtr  = m_pWarningHook;
       curtag->SetTagSet();
       break;
+    case JPGTAG_MIO_LIMIT:
+      curtag->ti_Data.ti_lData = KiloBytesOf(m_uqMemLimit);
+      curtag->SetTagSet();
+      break;
+    case JPGTAG_MIO_CURRENT:
+      curtag->ti_Data.ti_lData = KiloBytesOf(m_uqCurrentMem);
+      curtag->SetTagSet();
+      break;
+    case JPGTAG_MIO_PEAK:
+      curtag->ti_Data.ti_lData = KiloBytesOf(m_uqPeakMem);
+      curtag->SetTagSet();
+      break;
+    default:
+      if (curtag->ti_Tag >= JPGTAG_MIO_CURRENT_TYPE(0) &&
+          curtag->ti_Tag <  JPGTAG_MIO_CURRENT_TYPE(JPGFLAG_MIO_TYPES)) {
+        curtag->ti_Data.ti_lData = KiloBytesOf(m_uqTypeMem[curtag->ti_Tag - JPGTAG_MIO_CURRENT_TYPE(0)]);
+        curtag->SetTagSet();
+      } else if (curtag->ti_Tag >= JPGTAG_MIO_PEAK_TYPE(0) &&
+                 curtag->ti_Tag <  JPGTAG_MIO_PEAK_TYPE(JPGFLAG_MIO_TYPES)) {
+        curtag->ti_Data.ti_lData = KiloBytesOf(m_uqTypePeak[curtag->ti_Tag - JPGTAG_MIO_PEAK_TYPE(0)]);
+        curtag->SetTagSet();
+      }
+      break;
     }
   }
 }
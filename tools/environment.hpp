@@ -286,7 +286,9 @@ needs the exception stack of the previously active exepction stack,
 i.e. the jump position of the upper "TRY" block, and not the jump-
 block of the currently active "TRY"-block.
 
-For "jumping", we use the C setjmp/longjmp function calls. Note,
+For "jumping", we use the C setjmp/longjmp function calls, or their
+_setjmp/_longjmp variants if available since these do not touch the
+signal mask, see std/setjmp.hpp. Note,
 however, that calling "SetJump" will not call the destructors of
 the auto objects currently on the stack such that we *must not*
 keep such objects. This is a *very important* design change from
@@ -532,6 +534,22 @@ private:
   // If the following bool is set, then the library tries
   // to suppress multiple identical warnings.
   bool                   m_bSuppressMultiple;
+  //
+  // Memory statistics: The number of bytes currently allocated
+  // and the maximum so far, in total and per memory type.
+  UQUAD                  m_uqCurrentMem;
+  UQUAD                  m_uqPeakMem;
+  UQUAD                  m_uqTypeMem[JPGFLAG_MIO_TYPES];
+  UQUAD                  m_uqTypePeak[JPGFLAG_MIO_TYPES];
+  //
+  // The hard limit on the allocated memory in bytes, or zero
+  // if there is no limit.
+  UQUAD                  m_uqMemLimit;
+  //
+#if CHECK_LEVEL > 0
+  // The number of allocations performed, for debugging only.
+  ULONG                  m_ulAllocCount;
+#endif
   //
   // The number of warnings we keep at most. This should be sufficient
   // for most runs.
@@ -548,8 +566,12 @@ private:
                       const class Exception &exc);
   //
   // Internal memory allocation functions, not for public use.
-  inline void *CoreAllocMem(ULONG bytesize,ULONG reqments);
-  inline void CoreFreeMem(void *mem,ULONG bytesize);
+  // The type is the memory type the allocation is accounted to.
+  inline void *CoreAllocMem(ULONG bytesize,ULONG reqments,UBYTE type);
+  inline void CoreFreeMem(void *mem,ULONG bytesize,UBYTE type);
+  //
+  // Reset the memory statistics and read the limit from the tags.
+  void ResetMemoryStatistics(struct JPG_TagItem *tags);
   //
   // Check whether the given warning (at the line and source file) is already
   // in the warning database. In case it is, return false. Otherwise, enter
@@ -597,19 +619,24 @@ public:
   //
   // Memory allocation and deallocation functions:
   //
-  // Takes a byte size and a requirement factor. The latter is not
-  // yet in use. Note that it is slightly more effective not to
-  // use a default argument here.
+  // Takes a byte size and a requirement factor. The latter is the
+  // memory type, one of the JPGFLAG_MIO types, which is passed
+  // to the allocation hook and used for the memory statistics.
+  // Note that it is slightly more effective not to use a default
+  // argument here.
   void *AllocMem(size_t bytesize,ULONG requirements);
   void *AllocMem(size_t bytesize);
   //
-  // The same again, but this call remembers the size
+  // The same again, but this call remembers the size. As the type
+  // is not remembered, the memory is accounted as generic memory.
   void *AllocVec(size_t bytesize,ULONG requirements);
   void *AllocVec(size_t bytesize); 
   //
   // Free memory: Takes the memory pointer and the size of memory
-  // to be deallocated.
+  // to be deallocated, and the requirements it was allocated with
+  // if they were not zero.
   void FreeMem(void *mem,size_t bytesize);
+  void FreeMem(void *mem,size_t bytesize,ULONG requirements);
   // Free a thing allocated by AllocVec, no bytesize required here.
   void FreeVec(void *mem);
   //
@@ -739,11 +766,11 @@ void ExceptionStack::Link(class Environ *env)
   __exc__.m_pFile = __FILE__;                  \
   __exc__.m_iLine = __LINE__;                  \
   m_pEnviron->TestCaller();                    \
-  if (likely(setjmp(__exc__.m_JumpDestination) == 0))
+  if (likely(JPG_SETJMP(__exc__.m_JumpDestination) == 0))
 #else
 #define JPG_TRY                                \
 { class ExceptionStack __exc__(m_pEnviron);    \
-  if (likely(setjmp(__exc__.m_JumpDestination) == 0))
+  if (likely(JPG_SETJMP(__exc__.m_JumpDestination) == 0))
 #endif
 
 // A catch macro: This is simply the else-part of the setjmp above.
@@ -65,4 +65,42 @@ ULONG  IEEEEncode(FLOAT number);
 UQUAD  IEEEEncode(DOUBLE number);
 ///
 
+/// Bit scanning
+// Return the index of the least significant bit set in a non-zero
+// 64 bit mask.
+inline int LowestBitOf(UQUAD mask)
+{
+#ifdef HAVE_BUILTIN_CTZLL
+  return __builtin_ctzll(mask);
+#else
+  int bit = 0;
+  //
+  if ((mask & 0xffffffffUL) == 0) {
+    mask >>= 32;
+    bit   += 32;
+  }
+  if ((mask & 0xffff) == 0) {
+    mask >>= 16;
+    bit   += 16;
+  }
+  if ((mask & 0xff) == 0) {
+    mask >>= 8;
+    bit   += 8;
+  }
+  if ((mask & 0x0f) == 0) {
+    mask >>= 4;
+    bit   += 4;
+  }
+  if ((mask & 0x03) == 0) {
+    mask >>= 2;
+    bit   += 2;
+  }
+  if ((mask & 0x01) == 0)
+    bit   += 1;
+  //
+  return bit;
+#endif
+}
+///
+
 #endif
@@ -72,6 +72,22 @@ public:
     *next   = (T *)this;
   }
   //
+  // Insert into an existing queue, using a node already in the queue
+  // as a hint where to start searching. If the priority of the hint
+  // is not larger than the given priority, insertion starts behind the
+  // hint, which makes appending in priority order an O(1) operation.
+  PriorityQueue(T *&head,T *hint,ULONG prior)
+    : m_ulPrior(prior)
+  {
+    T **next = (hint && hint->m_ulPrior <= prior)?(&(hint->m_pNext)):(&head);
+    //
+    while(*next && (*next)->m_ulPrior <= prior) {
+      next = &((*next)->m_pNext);
+    }
+    m_pNext = *next;
+    *next   = (T *)this;
+  }
+  //
   // Return the next element of this list.
   T *NextOf(void) const
   {
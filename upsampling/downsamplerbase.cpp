@@ -56,13 +56,13 @@ DownsamplerBase::~DownsamplerBase(void)
   while((row = m_pInputBuffer)) {
     m_pInputBuffer = row->m_pNext;
     if (row->m_pData)
-      m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG));
+      m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG),JPGFLAG_MIO_LINES);
     delete row;
   } 
 
   while((row = m_pFree)) {
     m_pFree = row->m_pNext;
-    m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG));
+    m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG),JPGFLAG_MIO_LINES);
     delete row;
   }
 }
@@ -112,7 +112,8 @@ void DownsamplerBase::ExtendBufferedRegion(const RectAngle<LONG> &region)
     //
     // Allocate the memory for it.
     if (alloc) {
-      alloc->m_pData = (LONG *)m_pEnviron->AllocMem((m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG));
+      alloc->m_pData = (LONG *)m_pEnviron->AllocMem((m_ulWidth + (m_ucSubX << 3)) * sizeof(LONG),
+                                                       JPGFLAG_MIO_LINES);
     }
     m_lHeight++;
   }
@@ -65,13 +65,13 @@ UpsamplerBase::~UpsamplerBase(void)
   while((row = m_pInputBuffer)) {
     m_pInputBuffer = row->m_pNext;
     if (row->m_pData)
-      m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + 2 + 8) * sizeof(LONG));
+      m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + 2 + 8) * sizeof(LONG),JPGFLAG_MIO_LINES);
     delete row;
   } 
 
   while((row = m_pFree)) {
     m_pFree = row->m_pNext;
-    m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + 2 + 8) * sizeof(LONG));
+    m_pEnviron->FreeMem(row->m_pData,(m_ulWidth + 2 + 8) * sizeof(LONG),JPGFLAG_MIO_LINES);
     delete row;
   }
 }
@@ -233,7 +233,7 @@ void UpsamplerBase::ExtendBufferedRegion(const RectAngle<LONG> &region)
     //
     // Allocate the memory for it.
     if (alloc) {
-      alloc->m_pData = (LONG *)m_pEnviron->AllocMem((m_ulWidth + 2 + 8) * sizeof(LONG));
+      alloc->m_pData = (LONG *)m_pEnviron->AllocMem((m_ulWidth + 2 + 8) * sizeof(LONG),JPGFLAG_MIO_LINES);
     }
     m_lHeight++;
   }